@@ -1,3 +1,5 @@
+// Separately chained hash map, which the compiler used before template/flat_map.h
+// kept only as the baseline for bench/map.c
 // define 
 // MAP_TYPE            | Name for map type e.g. StringIntMap
 // MAP_KEY_TYPE        | Type of keys e.g. char const *
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cc/common.h"
+#include "cc/hash.h"
+#include "cc/slice.h"
+
+// Compares charslice_hash with djb2, which it replaced, on sets of generated identifiers:
+// - probes: average slots visited per insert into a linear-probing table at load <= 1/2, like
+//   the interner's (which keeps 32 bits of the hash)
+// - collisions: pairs of names with the same 32-bit hash
+// - ns/hash: the best of several passes over the set
+
+#define NAME_COUNT 100000u
+#define NAME_LEN 48u
+#define TIMING_PASSES 20u
+
+typedef usize (*HashFunction)(struct CharSlice);
+
+static char names[NAME_COUNT][NAME_LEN];
+static struct CharSlice name_slices[NAME_COUNT];
+
+static usize djb2(struct CharSlice const s) {
+    usize hash = 5381u;
+    for (usize i = 0u; i < s.len; i += 1u) {
+        hash = ((hash << 5u) + hash) + (usize) s.ptr[i];
+    }
+
+    return hash;
+}
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+static i32 compare_u32(void const *const a, void const *const b) {
+    u32 const left = *(u32 const *) a;
+    u32 const right = *(u32 const *) b;
+
+    return left < right ? -1 : left > right;
+}
+
+struct HashQuality {
+    double probes_per_insert;
+    usize collisions;
+};
+
+static struct HashQuality measure_quality(HashFunction const hash_function, usize const count) {
+    usize table_size = 1u;
+    while (table_size < 2u * count) {
+        table_size *= 2u;
+    }
+
+    bool *const is_used = calloc(table_size, sizeof (bool));
+    u32 *const hashes = malloc(count * sizeof (u32));
+    usize probe_count = 0u;
+
+    for (usize i = 0u; i < count; i += 1u) {
+        hashes[i] = (u32) hash_function(name_slices[i]);
+
+        usize slot = hashes[i] & (table_size - 1u);
+        probe_count += 1u;
+        while (is_used[slot]) {
+            slot = (slot + 1u) & (table_size - 1u);
+            probe_count += 1u;
+        }
+        is_used[slot] = true;
+    }
+
+    qsort(hashes, count, sizeof (u32), compare_u32);
+    usize collisions = 0u;
+    for (usize i = 1u; i < count; i += 1u) {
+        collisions += hashes[i] == hashes[i - 1u] ? 1u : 0u;
+    }
+
+    free(is_used);
+    free(hashes);
+
+    return (struct HashQuality) {
+        .probes_per_insert = (double) probe_count / (double) count,
+        .collisions = collisions,
+    };
+}
+
+// best time per hash, in nanoseconds
+static double measure_speed(HashFunction const hash_function, usize const count, usize *const checksum) {
+    double best = 1e9;
+
+    for (usize pass = 0u; pass < TIMING_PASSES; pass += 1u) {
+        double const start = now_seconds();
+        for (usize i = 0u; i < count; i += 1u) {
+            *checksum += hash_function(name_slices[i]);
+        }
+        double const elapsed = now_seconds() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best / (double) count * 1e9;
+}
+
+i32 main(void) {
+    char const *const set_names[] = { "var_<i>", "local_<i>_<j>", "func_<i>", "a_much_longer_identifier_name_<i>" };
+    usize const set_counts[] = { 10000u, NAME_COUNT, NAME_COUNT, NAME_COUNT };
+    // keeps the hashing from being optimized away
+    usize checksum = 0u;
+
+    printf(
+        "%-34s %7s  %17s  %17s  %17s\n",
+        "set", "n", "probes djb2/new", "collisions d/new", "ns/hash djb2/new"
+    );
+
+    for (usize set = 0u; set < sizeof (set_counts) / sizeof (set_counts[0]); set += 1u) {
+        usize const count = set_counts[set];
+
+        for (usize i = 0u; i < count; i += 1u) {
+            switch (set) {
+                case 0u: snprintf(names[i], NAME_LEN, "var_%04zu", i); break;
+                case 1u: snprintf(names[i], NAME_LEN, "local_%zu_%zu", i % 5u, i / 5u); break;
+                case 2u: snprintf(names[i], NAME_LEN, "func_%zu", i); break;
+                default: snprintf(names[i], NAME_LEN, "a_much_longer_identifier_name_%zu", i); break;
+            }
+            name_slices[i] = (struct CharSlice) { .ptr = names[i], .len = strlen(names[i]) };
+        }
+
+        struct HashQuality const djb2_quality = measure_quality(djb2, count);
+        struct HashQuality const new_quality = measure_quality(charslice_hash, count);
+        double const djb2_ns = measure_speed(djb2, count, &checksum);
+        double const new_ns = measure_speed(charslice_hash, count, &checksum);
+
+        printf(
+            "%-34s %7zu  %7.2f / %7.2f  %7zu / %7zu  %7.2f / %7.2f\n",
+            set_names[set],
+            count,
+            djb2_quality.probes_per_insert,
+            new_quality.probes_per_insert,
+            djb2_quality.collisions,
+            new_quality.collisions,
+            djb2_ns,
+            new_ns
+        );
+    }
+
+    printf("(checksum %zu)\n", checksum & 1u);
+
+    return 0;
+}
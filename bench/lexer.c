@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cc/common.h"
+#include "cc/interner.h"
+#include "cc/lexer.h"
+#include "cc/slice.h"
+#include "cc/token.h"
+
+// Keyword recognition with the lexer's 64-slot perfect hash against the chain of
+// charslice_eq_cstr calls it replaced, in tokens/s:
+// - lookup: classifying a stream of words (half of them keywords, like C code) on their own
+// - lexer: lexer_next_token over generated source, which uses the perfect hash
+
+#define WORD_COUNT 1000000u
+#define WORD_LEN 16u
+#define TIMING_PASSES 10u
+#define SOURCE_FUNCTION_COUNT 100000u
+
+// the keywords the old chain recognized, in its order (it missed `else`)
+static enum TokenKind chain_keyword_kind(struct CharSlice const word) {
+    if (charslice_eq_cstr(word, "return")) {
+        return TokenKeywordReturn;
+    } else if (charslice_eq_cstr(word, "if")) {
+        return TokenKeywordIf;
+    } else if (charslice_eq_cstr(word, "do")) {
+        return TokenKeywordDo;
+    } else if (charslice_eq_cstr(word, "while")) {
+        return TokenKeywordWhile;
+    } else if (charslice_eq_cstr(word, "for")) {
+        return TokenKeywordFor;
+    } else if (charslice_eq_cstr(word, "switch")) {
+        return TokenKeywordSwitch;
+    } else if (charslice_eq_cstr(word, "continue")) {
+        return TokenKeywordContinue;
+    } else if (charslice_eq_cstr(word, "break")) {
+        return TokenKeywordBreak;
+    } else if (charslice_eq_cstr(word, "const")) {
+        return TokenKeywordConst;
+    } else if (charslice_eq_cstr(word, "void")) {
+        return TokenKeywordVoid;
+    } else if (charslice_eq_cstr(word, "int")) {
+        return TokenKeywordInt;
+    } else if (charslice_eq_cstr(word, "signed")) {
+        return TokenKeywordSigned;
+    } else if (charslice_eq_cstr(word, "unsigned")) {
+        return TokenKeywordUnsigned;
+    } else if (charslice_eq_cstr(word, "long")) {
+        return TokenKeywordLong;
+    } else if (charslice_eq_cstr(word, "short")) {
+        return TokenKeywordShort;
+    } else if (charslice_eq_cstr(word, "char")) {
+        return TokenKeywordChar;
+    } else if (charslice_eq_cstr(word, "float")) {
+        return TokenKeywordFloat;
+    } else if (charslice_eq_cstr(word, "double")) {
+        return TokenKeywordDouble;
+    } else {
+        return TokenIdentifier;
+    }
+}
+
+typedef enum TokenKind (*KeywordKindFunction)(struct CharSlice);
+
+static char words[WORD_COUNT][WORD_LEN];
+static struct CharSlice word_slices[WORD_COUNT];
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// xorshift32
+static u32 random_u32(u32 *const state) {
+    *state ^= *state << 13u;
+    *state ^= *state >> 17u;
+    *state ^= *state << 5u;
+
+    return *state;
+}
+
+// best rate over several passes, in tokens/s
+static double measure_lookup(KeywordKindFunction const keyword_kind, usize *const checksum) {
+    double best = 1e9;
+
+    for (usize pass = 0u; pass < TIMING_PASSES; pass += 1u) {
+        double const start = now_seconds();
+        for (usize i = 0u; i < WORD_COUNT; i += 1u) {
+            *checksum += (usize) keyword_kind(word_slices[i]);
+        }
+        double const elapsed = now_seconds() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return (double) WORD_COUNT / best;
+}
+
+i32 main(void) {
+    // keeps the lookups from being optimized away
+    usize checksum = 0u;
+
+    // lookup
+
+    char const *const keywords[] = { "int", "return", "long", "if", "while", "char", "unsigned", "for" };
+    usize const keyword_count = sizeof (keywords) / sizeof (keywords[0]);
+    u32 random_state = 1u;
+
+    for (usize i = 0u; i < WORD_COUNT; i += 1u) {
+        u32 const random = random_u32(&random_state);
+
+        if (random % 2u == 0u) {
+            snprintf(words[i], WORD_LEN, "%s", keywords[(random / 2u) % keyword_count]);
+        } else {
+            snprintf(words[i], WORD_LEN, "var_%u", (random / 2u) % 10000u);
+        }
+        word_slices[i] = (struct CharSlice) { .ptr = words[i], .len = strlen(words[i]) };
+    }
+
+    for (usize i = 0u; i < WORD_COUNT; i += 1u) {
+        if (lexer_keyword_kind(word_slices[i]) != chain_keyword_kind(word_slices[i])) {
+            printf("the lookups disagree on %s\n", words[i]);
+            return 1;
+        }
+    }
+
+    double const chain_rate = measure_lookup(chain_keyword_kind, &checksum);
+    double const hash_rate = measure_lookup(lexer_keyword_kind, &checksum);
+
+    printf(
+        "lookup of %u words: charslice_eq_cstr chain %7.1f Mtokens/s, perfect hash %7.1f Mtokens/s\n",
+        WORD_COUNT,
+        chain_rate / 1e6,
+        hash_rate / 1e6
+    );
+
+    // lexer
+
+    char const *const function_format =
+        "int f%zu(int a, long b) {\n"
+        "    long x = a * b + %zu;\n"
+        "    if (x) {\n"
+        "        return x;\n"
+        "    }\n"
+        "    return a - b;\n"
+        "}\n";
+
+    usize const source_capacity = SOURCE_FUNCTION_COUNT * 128u;
+    char *const source = malloc(source_capacity);
+    usize source_len = 0u;
+    for (usize i = 0u; i < SOURCE_FUNCTION_COUNT; i += 1u) {
+        source_len += (usize) snprintf(source + source_len, source_capacity - source_len, function_format, i, i);
+    }
+
+    double best = 1e9;
+    usize token_count = 0u;
+
+    for (usize pass = 0u; pass < TIMING_PASSES; pass += 1u) {
+        struct Interner interner;
+        interner_init(&interner);
+        struct Lexer lexer;
+        lexer_init(&lexer, source, 0u, &interner);
+
+        token_count = 0u;
+        double const start = now_seconds();
+        for (;;) {
+            struct Token const token = lexer_next_token(&lexer);
+            token_count += 1u;
+            if (token.kind == TokenEof) {
+                break;
+            }
+        }
+        double const elapsed = now_seconds() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+        interner_free(&interner);
+    }
+
+    printf(
+        "lexer over %zu bytes: %zu tokens, %7.1f Mtokens/s\n",
+        source_len,
+        token_count,
+        (double) token_count / best / 1e6
+    );
+
+    free(source);
+
+    printf("(checksum %zu)\n", checksum & 1u);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cc/common.h"
+#include "cc/interner.h"
+
+// Compares template/flat_map.h with the chained map it replaced, for u32 symbol keys (the
+// variable tables): inserts of `n` keys, then lookups of random keys of which half are present
+//
+// the chained map gets the 1021 buckets the function index used to have, the flat map starts
+// small and grows
+
+#define MAP_TYPE            ChainedMap
+#define MAP_KEY_TYPE        u32
+#define MAP_VALUE_TYPE      usize
+#define MAP_FUNCTION_PREFIX chained_map__
+#define MAP_KEY_EQ_FN       symbol_eq
+#define MAP_KEY_HASH_FN     symbol_hash
+#include "chained_map.h"
+#include "chained_map.inl"
+#undef MAP_TYPE
+#undef MAP_FUNCTION_PREFIX
+
+#define MAP_TYPE            FlatMap
+#define MAP_FUNCTION_PREFIX flat_map__
+#include "cc/template/flat_map.h"
+#include "cc/template/flat_map.inl"
+#undef MAP_TYPE
+#undef MAP_KEY_TYPE
+#undef MAP_VALUE_TYPE
+#undef MAP_FUNCTION_PREFIX
+#undef MAP_KEY_EQ_FN
+#undef MAP_KEY_HASH_FN
+
+#define CHAINED_TABLE_SIZE 1021u
+#define FLAT_INITIAL_CAPACITY 64u
+#define LOOKUP_COUNT 10000000u
+// lookup keys are drawn from a table of this many (a power of two)
+#define LOOKUP_KEY_COUNT ((usize) 1u << 20u)
+// keys are spread out rather than consecutive
+#define KEY_STRIDE 7u
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// xorshift32
+static u32 random_u32(u32 *const state) {
+    *state ^= *state << 13u;
+    *state ^= *state >> 17u;
+    *state ^= *state << 5u;
+
+    return *state;
+}
+
+i32 main(void) {
+    u32 *const lookup_keys = malloc(LOOKUP_KEY_COUNT * sizeof (u32));
+    usize const sizes[] = { 100u, 1000u, 10000u, 100000u };
+    // keeps the lookups from being optimized away
+    usize checksum = 0u;
+
+    printf("%8s  %16s %16s  %16s %16s\n", "n", "insert chained", "insert flat", "lookup chained", "lookup flat");
+
+    for (usize size_index = 0u; size_index < sizeof (sizes) / sizeof (sizes[0]); size_index += 1u) {
+        usize const n = sizes[size_index];
+
+        struct ChainedMap chained;
+        chained_map__init(&chained, CHAINED_TABLE_SIZE);
+        struct FlatMap flat;
+        flat_map__init(&flat, FLAT_INITIAL_CAPACITY);
+
+        double const chained_insert_start = now_seconds();
+        for (u32 i = 0u; i < n; i += 1u) {
+            chained_map__set(&chained, i * KEY_STRIDE, i);
+        }
+        double const flat_insert_start = now_seconds();
+        for (u32 i = 0u; i < n; i += 1u) {
+            flat_map__set(&flat, i * KEY_STRIDE, i);
+        }
+        double const insert_end = now_seconds();
+
+        u32 random_state = 1u;
+        for (usize i = 0u; i < LOOKUP_KEY_COUNT; i += 1u) {
+            lookup_keys[i] = (random_u32(&random_state) % (u32) (2u * n)) * KEY_STRIDE;
+        }
+
+        double const chained_lookup_start = now_seconds();
+        for (usize i = 0u; i < LOOKUP_COUNT; i += 1u) {
+            usize const *const value = chained_map__get(&chained, lookup_keys[i & (LOOKUP_KEY_COUNT - 1u)]);
+            checksum += value == NULL ? 0u : *value;
+        }
+        double const flat_lookup_start = now_seconds();
+        for (usize i = 0u; i < LOOKUP_COUNT; i += 1u) {
+            usize const *const value = flat_map__get(&flat, lookup_keys[i & (LOOKUP_KEY_COUNT - 1u)]);
+            checksum -= value == NULL ? 0u : *value;
+        }
+        double const lookup_end = now_seconds();
+
+        printf(
+            "%8zu  %13.1f ns %13.1f ns  %13.1f ns %13.1f ns\n",
+            n,
+            (flat_insert_start - chained_insert_start) / (double) n * 1e9,
+            (insert_end - flat_insert_start) / (double) n * 1e9,
+            (flat_lookup_start - chained_lookup_start) / LOOKUP_COUNT * 1e9,
+            (lookup_end - flat_lookup_start) / LOOKUP_COUNT * 1e9
+        );
+
+        chained_map__free(&chained);
+        flat_map__free(&flat);
+    }
+
+    free(lookup_keys);
+
+    // both maps hold the same values, so the sums cancel out
+    if (checksum != 0u) {
+        printf("the maps disagree\n");
+        return 1;
+    }
+
+    return 0;
+}
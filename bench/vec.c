@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cc/common.h"
+#include "cc/slice.h"
+
+// Push throughput of template/vec.h against the growth it replaced, and of template/small_vec.h
+// against vec.h for many short-lived vecs
+//
+// the old resize never recorded the new capacity, so reserve always found the vec full and every
+// push reallocated (to 3/2 of the length); old_vec_push reproduces that
+
+#define VEC_ELEMENT_TYPE    usize
+#define VEC_SLICE_TYPE      UsizeSlice
+#define VEC_TYPE            BenchVec
+#define VEC_FUNCTION_PREFIX benchvec_
+#include "cc/template/vec.h"
+#include "cc/template/vec.inl"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+#define SMALLVEC_TYPE            BenchSmallVec
+#define SMALLVEC_ELEMENT_TYPE    usize
+#define SMALLVEC_INLINE_CAPACITY 8u
+#define SMALLVEC_SLICE_TYPE      UsizeSlice
+#define SMALLVEC_FUNCTION_PREFIX benchsmallvec_
+#include "cc/template/small_vec.h"
+#include "cc/template/small_vec.inl"
+#undef SMALLVEC_TYPE
+#undef SMALLVEC_ELEMENT_TYPE
+#undef SMALLVEC_INLINE_CAPACITY
+#undef SMALLVEC_SLICE_TYPE
+#undef SMALLVEC_FUNCTION_PREFIX
+
+#define LONG_VEC_PASSES 5u
+#define SHORT_VEC_COUNT 1000000u
+
+struct OldVec {
+    usize *data;
+    usize len;
+};
+
+static void old_vec_push(struct OldVec *const self, usize const element) {
+    self->data = realloc(self->data, ((self->len + 1u) * 3u) / 2u * sizeof (usize));
+    if (self->data == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    self->data[self->len] = element;
+    self->len += 1u;
+}
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+i32 main(void) {
+    // keeps the pushes from being optimized away
+    usize checksum = 0u;
+
+    // long vecs, best of several passes
+
+    for (usize count = 1000u; count <= 10000000u; count *= 100u) {
+        double best_old = 1e9;
+        double best_new = 1e9;
+
+        for (usize pass = 0u; pass < LONG_VEC_PASSES; pass += 1u) {
+            struct OldVec old_vec = { .data = NULL, .len = 0u };
+            double const old_start = now_seconds();
+            for (usize i = 0u; i < count; i += 1u) {
+                old_vec_push(&old_vec, i);
+            }
+            double const old_elapsed = now_seconds() - old_start;
+            checksum += old_vec.data[count / 2u];
+            free(old_vec.data);
+
+            struct BenchVec vec;
+            benchvec_init(&vec);
+            double const new_start = now_seconds();
+            for (usize i = 0u; i < count; i += 1u) {
+                benchvec_push(&vec, i);
+            }
+            double const new_elapsed = now_seconds() - new_start;
+            checksum += vec.data[count / 2u];
+            benchvec_free(&vec);
+
+            best_old = old_elapsed < best_old ? old_elapsed : best_old;
+            best_new = new_elapsed < best_new ? new_elapsed : best_new;
+        }
+
+        printf(
+            "push %8zu elements: old %6.2f ns/push, new %5.2f ns/push\n",
+            count,
+            best_old / (double) count * 1e9,
+            best_new / (double) count * 1e9
+        );
+    }
+
+    // many short-lived vecs
+
+    for (usize len = 2u; len <= 32u; len *= 4u) {
+        double const vec_start = now_seconds();
+        for (usize vec_index = 0u; vec_index < SHORT_VEC_COUNT; vec_index += 1u) {
+            struct BenchVec vec;
+            benchvec_init(&vec);
+            for (usize i = 0u; i < len; i += 1u) {
+                benchvec_push(&vec, i);
+            }
+            checksum += vec.data[len - 1u];
+            benchvec_free(&vec);
+        }
+        double const small_vec_start = now_seconds();
+        for (usize vec_index = 0u; vec_index < SHORT_VEC_COUNT; vec_index += 1u) {
+            struct BenchSmallVec vec;
+            benchsmallvec_init(&vec);
+            for (usize i = 0u; i < len; i += 1u) {
+                benchsmallvec_push(&vec, i);
+            }
+            checksum += *benchsmallvec_peek_back(&vec);
+            benchsmallvec_free(&vec);
+        }
+        double const small_vec_end = now_seconds();
+
+        printf(
+            "%u short-lived vecs of %2zu elements: vec %6.1f ns/vec, small vec (8 inline) %6.1f ns/vec\n",
+            SHORT_VEC_COUNT,
+            len,
+            (small_vec_start - vec_start) / SHORT_VEC_COUNT * 1e9,
+            (small_vec_end - small_vec_start) / SHORT_VEC_COUNT * 1e9
+        );
+    }
+
+    printf("(checksum %zu)\n", checksum & 1u);
+
+    return 0;
+}
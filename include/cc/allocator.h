@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cc/arena.h"
+#include "cc/common.h"
+
+// Memory for the vec and map templates (see VEC_ALLOCATOR and MAP_ALLOCATOR)
+// Callers pass back the size of the allocation, so allocators need not store it
+struct Allocator {
+    void *(*alloc)(void *context, usize len);
+    // `ptr` may be NULL, with `old_len` 0
+    void *(*realloc)(void *context, void *ptr, usize old_len, usize new_len);
+    // `ptr` may be NULL
+    void (*free)(void *context, void *ptr, usize len);
+    void *context;
+};
+
+// malloc, realloc and free
+extern struct Allocator const heap_allocator;
+
+// size classes of a pool: 16 bytes, 32 bytes, ... 512 KiB
+#define POOL_SIZE_CLASS_COUNT 16u
+
+// Arena with free lists: freed allocations are reused by later allocations of the same size 
+// class, so tables that grow and shrink do not pile up dead memory, and `pool_free` still 
+// releases everything at once
+struct Pool {
+    struct Arena arena;
+    // free allocations of each size class, linked through their first word
+    void *free_lists[POOL_SIZE_CLASS_COUNT];
+};
+
+void pool_init(struct Pool *self, usize block_len);
+void pool_free(struct Pool *self);
+struct Allocator pool_allocator(struct Pool *pool);
+
+static inline void *allocator_alloc(struct Allocator const *const self, usize const len) {
+    return self->alloc(self->context, len);
+}
+
+static inline void *allocator_realloc(
+    struct Allocator const *const self, 
+    void *const ptr, 
+    usize const old_len, 
+    usize const new_len
+) {
+    return self->realloc(self->context, ptr, old_len, new_len);
+}
+
+static inline void allocator_free(struct Allocator const *const self, void *const ptr, usize const len) {
+    self->free(self->context, ptr, len);
+}
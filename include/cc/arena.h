@@ -2,12 +2,57 @@
 
 #include "cc/common.h"
 
+// Alignment of pointers returned by `arena_alloc`, enough for any AST node
+#define ARENA_DEFAULT_ALIGNMENT 8u
+
 struct ArenaBlock;
 
+// Bump allocator
+// Small allocations are bumped from the current block. When it is full, a new block is 
+// added, each one twice the size of the previous one (up to a limit). Allocations too large 
+// for a regular block get a dedicated block of their own
+// An arena made with `arena_init_reserved` starts with one block spanning a large range of 
+// reserved address space, whose pages are committed as allocations reach them. The range is 
+// never moved, so an `ArenaVec` at the top of the arena can grow in place 
 struct Arena {
-    struct ArenaBlock *blocks;
-    usize block_count;
+    // Block allocations are bumped from (NULL before the first allocation)
+    struct ArenaBlock *current;
+    // Dedicated blocks of oversized allocations, newest first
+    struct ArenaBlock *oversized;
+    // Block most recently released by `arena_reset_to_mark`, reused by the next new block
+    struct ArenaBlock *spare;
+    // Block in the reserved address range (NULL unless made with `arena_init_reserved`)
+    struct ArenaBlock *reserved;
+    void *reservation;
+    usize reservation_len;
+    // Pages of the reserved block are committed this many bytes at a time
+    usize commit_len;
+    // Size of the first block
     usize block_len;
+    usize bytes_requested;
+    usize bytes_reserved;
+    usize block_count;
+};
+
+// Position in an arena, everything allocated after it can be released with 
+// `arena_reset_to_mark`
+struct ArenaMark {
+    struct ArenaBlock *current;
+    usize used;
+    struct ArenaBlock *oversized;
+    usize bytes_requested;
+};
+
+// so that ARENA_BLOCK_LEN can be tuned
+struct ArenaStatistics {
+    // Bytes passed to the allocation functions
+    usize bytes_requested;
+    // Bytes in blocks that can no longer be used: alignment padding and the ends of blocks 
+    // that were too small for the next allocation
+    usize bytes_wasted;
+    // Total size of all blocks (only the committed part of a reserved block)
+    usize bytes_reserved;
+    usize block_count;
 };
 
 // Generic vec using an arena for backing storage
@@ -20,10 +65,16 @@ struct ArenaVec {
 };
 
 void arena_init(struct Arena *self, usize block_len);
+bool arena_init_reserved(struct Arena *self, usize block_len, usize reserve_len, bool use_huge_pages);
 void arena_free(struct Arena *self);
 void *arena_alloc(struct Arena *self, usize len);
+void *arena_alloc_aligned(struct Arena *self, usize len, usize alignment);
 void *arena_copy(struct Arena *self, void const *item, usize item_size);
+bool arena_try_extend(struct Arena *self, void *ptr, usize len, usize new_len);
 void arena_clear(struct Arena *self);
+struct ArenaMark arena_mark(struct Arena const *self);
+void arena_reset_to_mark(struct Arena *self, struct ArenaMark mark);
+struct ArenaStatistics arena_statistics(struct Arena const *self);
 
 void arenavec_init(struct ArenaVec *self, struct Arena *backing_arena, usize element_size);
 void *arenavec_at(struct ArenaVec const *self, usize index);
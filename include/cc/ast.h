@@ -70,6 +70,7 @@ struct AstType {
 
 struct AstIdentifier {
     struct CharSlice name;
+    u32 symbol;
     struct AstNodePosition position;
 };
 
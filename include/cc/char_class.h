@@ -0,0 +1,31 @@
+#pragma once
+
+#include "cc/common.h"
+
+// Character classes for the lexer, and scanning kernels that skip over runs of a class.
+// On x86-64 the kernels use SSE2 or AVX2 (chosen at runtime with CPUID), elsewhere they fall 
+// back to the class table
+
+enum CharClass {
+    CharClassWhitespace = 1u << 0u, // ' ', '\t', '\n', '\r'
+    CharClassLetter     = 1u << 1u, // a-z, A-Z, _
+    CharClassDigit      = 1u << 2u, // 0-9
+};
+
+// classes of each byte value
+extern u8 char_class_table[256];
+
+// fill the class table and select the scanning kernels for this CPU
+void char_class_init(void);
+
+// the string must be NUL-terminated; the kernels may read (but never past) the aligned block 
+// containing the terminator
+
+// length of the run of whitespace at `ptr`
+usize scan_whitespace(char const *ptr);
+// length of the run of letters, digits and underscores at `ptr`
+usize scan_word(char const *ptr);
+
+static inline bool char_has_class(char const c, enum CharClass const char_class) {
+    return (char_class_table[(u8) c] & char_class) != 0u;
+}
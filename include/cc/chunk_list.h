@@ -0,0 +1,59 @@
+#pragma once
+
+#include "cc/common.h"
+
+// Output kept as a list of fixed-size chunks, so that it never has to be moved as it grows, 
+// and can be put together from several lists without copying
+// A list with a file descriptor streams its full chunks to the file as they pile up, so only 
+// the last few chunks of a large output are ever in memory
+// Bytes can be set aside to be filled in later (see `chunk_list_reserve`): chunks from the first 
+// one holding such a placeholder onwards stay in memory until every placeholder is patched
+
+#define CHUNK_LEN (64u * 1024u)
+
+struct Chunk {
+    struct Chunk *next;
+    usize len;
+    char data[CHUNK_LEN];
+};
+
+// bytes set aside by `chunk_list_reserve`, always within one chunk
+struct ChunkPlaceholder {
+    struct Chunk *chunk;
+    usize offset;
+    usize len;
+};
+
+struct ChunkList {
+    // chunks not yet written out, oldest first
+    struct Chunk *first;
+    struct Chunk *last;
+    usize chunk_count;
+    // file descriptor full chunks are written to, or -1 to keep every chunk in memory
+    i32 fd;
+    // chunks already written out, kept for reuse
+    struct Chunk *spare;
+    // placeholders not yet patched, and the chunk holding the oldest of them (NULL if none)
+    usize placeholder_count;
+    struct Chunk *pinned;
+};
+
+void chunk_list_init(struct ChunkList *self, i32 fd);
+// releases the chunks, whether or not they were written out (the file stays open)
+void chunk_list_free(struct ChunkList *self);
+
+// spare space of at least `min_len` bytes at the end of the list, and its length in 
+// `available_out`. Returns NULL if `min_len` is more than a chunk
+char *chunk_list_space(struct ChunkList *self, usize min_len, usize *available_out);
+// marks `len` bytes of the space returned by `chunk_list_space` as written
+void chunk_list_advance(struct ChunkList *self, usize len);
+
+// sets aside `len` bytes (at most a chunk), to be filled in with `chunk_list_patch`
+struct ChunkPlaceholder chunk_list_reserve(struct ChunkList *self, usize len);
+// fills in a placeholder with exactly `placeholder.len` bytes
+void chunk_list_patch(struct ChunkList *self, struct ChunkPlaceholder placeholder, char const *bytes);
+
+// moves the chunks of `other` to the end of `self`, leaving `other` empty
+void chunk_list_append(struct ChunkList *self, struct ChunkList *other);
+// writes every chunk to the file, with as few system calls as possible
+void chunk_list_flush(struct ChunkList *self);
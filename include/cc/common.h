@@ -34,6 +34,14 @@ static inline usize max_usize(usize const a, usize const b) {
     }
 }
 
+static inline usize min_usize(usize const a, usize const b) {
+    if (a < b) {
+        return a;
+    } else {
+        return b;
+    }
+}
+
 static inline usize round_up_usize(usize value, usize round) {
     usize const floor = (value / round) * round;
 
@@ -1,7 +1,14 @@
 #pragma once 
 
 #include "ast.h"
-#include "writer.h"
+#include "chunk_list.h"
+#include "compile/encoder.h"
 #include "compile/error.h"
 
-struct CompileResult compile(struct Writer *assembly_writer, struct AstRoot *const ast);
+// appends the assembly for `ast` to `assembly` (the text section first, so that a list streaming 
+// to a file can write it out while the data section is still growing)
+struct CompileResult compile(struct ChunkList *assembly, struct AstRoot *const ast);
+
+// machine code for `ast`, see compile/encoder.h. Calls to functions not defined in `ast` are left 
+// in the fixups of `text`
+struct CompileResult compile_code(struct CodeBuffer *text, struct CodeBuffer *data, struct AstRoot *const ast);
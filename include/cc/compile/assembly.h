@@ -110,16 +110,47 @@ struct Operand operand_stack(usize stack_offset);
 // returns the operand corresponding to the original operand displaced by `amount_bytes`
 struct Operand operand_displace(struct Operand operand, i64 amount_bytes);
 
+struct CodeBuffer;
+
+enum EmitterKind {
+    EmitterText,
+    EmitterCode,
+};
+
+// Where emitted instructions go: nasm assembly text, or machine code (see encoder.h)
+// The writer or code buffer must outlive the emitter
+struct Emitter {
+    enum EmitterKind kind;
+
+    union {
+        struct Writer *text;
+        struct CodeBuffer *code;
+    } variant;
+};
+
+struct Emitter text_emitter(struct Writer *writer);
+struct Emitter code_emitter(struct CodeBuffer *code);
+
+struct EmitterPlaceholder {
+    enum EmitterKind kind;
+
+    union {
+        struct WriterPlaceholder text;
+        // offset in the code buffer
+        usize code;
+    } variant;
+};
+
 void emit_operand(struct Writer *assembly_writer, struct Operand operand, enum OperandWidth width);
-void emit_instruction(struct Writer *assembly_writer, enum Instruction instruction);
+void emit_instruction(struct Emitter *emitter, enum Instruction instruction);
 void emit_instruction_single_operand(
-    struct Writer *assembly_writer, 
+    struct Emitter *emitter, 
     enum Instruction instruction, 
     enum OperandWidth operand_width,
     struct Operand operand
 );
 void emit_instruction_dst_src(
-    struct Writer *assembly_writer, 
+    struct Emitter *emitter, 
     enum Instruction instruction, 
     enum OperandWidth dst_width,
     enum OperandWidth src_width,
@@ -127,15 +158,22 @@ void emit_instruction_dst_src(
     struct Operand src
 );
 
-void emit_label(struct Writer *assembly_writer, struct CharSlice label);
-void emit_function_prologue(struct Writer *assembly_writer, usize stack_usage);
-void emit_function_exit(struct Writer *assembly_writer);
+void emit_label(struct Emitter *emitter, struct CharSlice label);
+// the stack adjustment of the prologue is only known once the body has been emitted, so it is 
+// left as a placeholder to be filled in by `patch_function_prologue`
+struct EmitterPlaceholder emit_function_prologue(struct Emitter *emitter);
+void patch_function_prologue(
+    struct Emitter *emitter, 
+    struct EmitterPlaceholder placeholder, 
+    usize stack_usage
+);
+void emit_function_exit(struct Emitter *emitter);
 
 // emit mov instructions as necessary to move src to dst 
 // may use `intermediate_register` as necessary
 // (0-2 instructions)
 void emit_move(
-    struct Writer *assembly_writer, 
+    struct Emitter *emitter, 
     struct Operand dst, 
     struct Operand src, 
     enum OperandWidth dst_operand_width,
@@ -147,7 +185,7 @@ void emit_move(
 // dst must not be a register if amount_bytes > 8
 // may use `intermediate_register` as necessary
 void emit_move_bytes(
-    struct Writer *assembly_writer, 
+    struct Emitter *emitter, 
     struct Operand dst, 
     struct Operand src, 
     usize size_bytes,
@@ -159,7 +197,7 @@ void emit_move_bytes(
 
 // move src to dst with type conversions
 void emit_assignment(
-    struct Writer *assembly_writer,
+    struct Emitter *emitter,
     struct Operand dst,
     struct Operand src,
     struct Type dst_type,
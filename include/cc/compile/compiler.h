@@ -10,10 +10,9 @@
 #include "cc/writer.h"
 
 struct Compiler {
-    // Assembly writers
-    struct Writer writer_text;
-    struct Writer writer_data;
-    struct Writer writer_function_body;
+    // Assembly text or machine code of each section
+    struct Emitter emitter_text;
+    struct Emitter emitter_data;
     // Symbol tables
     struct VariableTable *variable_table;
     struct FunctionTable *function_table;
@@ -24,13 +23,14 @@ struct Compiler {
     usize stack_offset_max;
 };
 
-void compiler_push_scope(struct Compiler *self, struct VariableTable *out_variable_table);
+void compiler_push_scope(struct Compiler *self);
 void compiler_pop_scope(struct Compiler *self);
 void compiler_init_function_context(struct Compiler *self, struct Type const *return_type);
 struct CompileResult compiler_declare_variable(
     struct Compiler *self, 
     struct VariableDescription *variable_desc_out, 
     struct CharSlice name, 
+    u32 symbol,
     struct Type type,
     struct AstNodePosition position
 );
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/compile/assembly.h"
+#include "cc/map.h"
+#include "cc/slice.h"
+#include "cc/vec.h"
+
+// x86-64 machine code for the instructions and operands of assembly.h, encoded the way nasm
+// would assemble the text emitted for them (up to the choice between equivalent encodings)
+
+// a rel32 field referring to a label that was not defined when it was encoded
+struct CodeFixup {
+    // offset of the rel32 field, which is relative to the end of the field
+    usize offset;
+    struct CharSlice label;
+};
+
+// a label and its offset in the code buffer
+struct CodeLabel {
+    struct CharSlice name;
+    usize offset;
+};
+
+// declare CodeLabelSlice and CodeLabelVec
+#define SLICE_TYPE CodeLabelSlice
+#define SLICE_ELEMENT_TYPE struct CodeLabel
+#define SLICE_FUNCTION_PREFIX codelabelslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE CodeLabelVec
+#define VEC_ELEMENT_TYPE struct CodeLabel
+#define VEC_SLICE_TYPE CodeLabelSlice
+#define VEC_FUNCTION_PREFIX codelabelvec_
+#include "cc/template/vec.h"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+// declare CodeFixupSlice and CodeFixupVec
+#define SLICE_TYPE CodeFixupSlice
+#define SLICE_ELEMENT_TYPE struct CodeFixup
+#define SLICE_FUNCTION_PREFIX codefixupslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE CodeFixupVec
+#define VEC_ELEMENT_TYPE struct CodeFixup
+#define VEC_SLICE_TYPE CodeFixupSlice
+#define VEC_FUNCTION_PREFIX codefixupvec_
+#include "cc/template/vec.h"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+// Machine code of one section, and the labels defined in it
+struct CodeBuffer {
+    struct CharVec bytes;
+    // labels in the order they were defined
+    struct CodeLabelVec labels;
+    // offset of every label defined so far
+    struct Map__CharSlice_usize label_offsets;
+    // references to labels that were not defined yet when they were encoded
+    struct CodeFixupVec fixups;
+};
+
+// "sub rsp, imm32", or a nop of the same length
+#define ENCODED_STACK_ADJUSTMENT_LEN 7u
+
+void code_buffer_init(struct CodeBuffer *self);
+void code_buffer_free(struct CodeBuffer *self);
+
+void code_buffer_define_label(struct CodeBuffer *self, struct CharSlice name);
+// patches the references to labels defined since they were encoded. The fixups left over refer
+// to labels defined outside of the buffer (e.g. library functions)
+void code_buffer_resolve_fixups(struct CodeBuffer *self);
+
+// sets aside `len` bytes to be filled in later, and returns their offset
+usize code_buffer_reserve(struct CodeBuffer *self, usize len);
+void code_buffer_patch(struct CodeBuffer *self, usize offset, char const *bytes, usize len);
+
+void encode_instruction(struct CodeBuffer *self, enum Instruction instruction);
+void encode_instruction_single_operand(
+    struct CodeBuffer *self,
+    enum Instruction instruction,
+    enum OperandWidth operand_width,
+    struct Operand const *operand
+);
+void encode_instruction_dst_src(
+    struct CodeBuffer *self,
+    enum Instruction instruction,
+    enum OperandWidth dst_width,
+    enum OperandWidth src_width,
+    struct Operand const *dst,
+    struct Operand const *src
+);
+
+// "sub rsp, `frame_size`" (as a 32-bit immediate, so the length does not depend on the size),
+// or a nop of the same length if `frame_size` is 0
+void encode_stack_adjustment(char out[ENCODED_STACK_ADJUSTMENT_LEN], usize frame_size);
@@ -2,6 +2,7 @@
 
 #include "cc/ast.h"
 #include "cc/slice.h"
+#include "cc/source_map.h"
 #include "cc/token.h"
 #include "cc/type.h"
 #include "cc/writer.h"
@@ -60,5 +61,9 @@ struct CompileResult {
 struct CompileResult compile_ok(void);
 struct CompileResult compile_error(struct CompileError error);
 
-void format_compile_error(struct Writer *writer, struct CompileError const *error);
+void format_compile_error(
+    struct Writer *writer, 
+    struct SourceMap *sources, 
+    struct CompileError const *error
+);
 
@@ -7,6 +7,7 @@
 
 struct FunctionDescription {
     struct CharSlice name;
+    u32 symbol;
     struct FunctionSignature signature;
     bool has_definition;
 };
@@ -25,37 +26,41 @@ struct FunctionDescription {
 #define VEC_ELEMENT_TYPE struct FunctionDescription 
 #define VEC_SLICE_TYPE FunctionDescriptionSlice
 #define VEC_FUNCTION_PREFIX fdvec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.h"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
 struct FunctionTable {
-    struct Map__CharSlice_usize function_index;
+    struct Map__u32_usize function_index;
     struct FunctionDescriptionVec function_descriptions;
 };
 
-void function_table_init(struct FunctionTable *self);
+void function_table_init(struct FunctionTable *self, struct Allocator const *allocator);
 void function_table_free(struct FunctionTable *self);
 
-bool function_table_has(struct FunctionTable *self, struct CharSlice name);
+bool function_table_has(struct FunctionTable *self, u32 symbol);
 
 bool function_table_get(
     struct FunctionTable const *self, 
-    struct CharSlice name, 
+    u32 symbol, 
     struct FunctionDescription *out
 ); 
 
 struct CompileResult function_table_declare(
     struct FunctionTable *self, 
     struct CharSlice name, 
+    u32 symbol,
     struct FunctionSignature const *signature,
     struct AstNodePosition position
 );
 struct CompileResult function_table_define(
     struct FunctionTable *self, 
     struct CharSlice name, 
+    u32 symbol,
     struct FunctionSignature const *signature,
     struct AstNodePosition position
 );
@@ -2,44 +2,91 @@
 
 #include "cc/ast.h"
 #include "cc/compile/error.h"
+#include "cc/interner.h"
 #include "cc/slice.h"
 #include "cc/type.h"
+#include "cc/vec.h"
 
 struct VariableDescription {
     struct CharSlice name;
+    u32 symbol;
     struct Type type;
     usize stack_offset;
 };
 
-#define MAP_TYPE            Map__CharSlice_VariableDescription
-#define MAP_KEY_TYPE        struct CharSlice 
-#define MAP_VALUE_TYPE      struct VariableDescription
-#define MAP_FUNCTION_PREFIX map__charslice_variabledescription__
-#define MAP_KEY_EQ_FN       charslice_eq
-#define MAP_KEY_HASH_FN     charslice_hash_djb2
-#include "cc/template/map.h"
+// the variable a symbol refers to, and the depth of the scope that declared it
+struct VariableBinding {
+    struct VariableDescription description;
+    usize scope_depth;
+};
+
+// a binding replaced by a declaration, restored when the declaring scope is popped
+struct VariableTableUndo {
+    u32 symbol;
+    bool has_previous;
+    struct VariableBinding previous;
+};
+
+#define MAP_TYPE            Map__u32_VariableBinding
+#define MAP_KEY_TYPE        u32
+#define MAP_VALUE_TYPE      struct VariableBinding
+#define MAP_FUNCTION_PREFIX map__u32_variablebinding__
+#define MAP_KEY_EQ_FN       symbol_eq
+#define MAP_KEY_HASH_FN     symbol_hash
+#define MAP_ALLOCATOR
+#include "cc/template/flat_map.h"
 #undef MAP_TYPE            
 #undef MAP_KEY_TYPE 
 #undef MAP_VALUE_TYPE      
 #undef MAP_FUNCTION_PREFIX 
 #undef MAP_KEY_EQ_FN       
 #undef MAP_KEY_HASH_FN     
+#undef MAP_ALLOCATOR
+
+// declare VariableTableUndoSlice and VariableTableUndoVec
+#define SLICE_TYPE VariableTableUndoSlice 
+#define SLICE_ELEMENT_TYPE struct VariableTableUndo 
+#define SLICE_FUNCTION_PREFIX variabletableundoslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
 
+#define VEC_TYPE VariableTableUndoVec 
+#define VEC_ELEMENT_TYPE struct VariableTableUndo 
+#define VEC_SLICE_TYPE VariableTableUndoSlice
+#define VEC_FUNCTION_PREFIX variabletableundovec_
+#define VEC_ALLOCATOR
+#include "cc/template/vec.h"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
+// all scopes share one table, which maps each symbol to its innermost binding
+// declaring a variable logs the binding it shadows, and popping a scope restores the bindings 
+// logged since it was pushed, so lookups take one probe and scopes allocate nothing
 struct VariableTable {
-    struct Map__CharSlice_VariableDescription variable_index; 
-    struct VariableTable *parent;
+    struct Map__u32_VariableBinding variable_index; 
+    struct VariableTableUndoVec undo_log;
+    // length of the undo log when each open scope was pushed, innermost last
+    struct UsizeVec scope_starts;
 };
 
-void variable_table_init(struct VariableTable *self, struct VariableTable *parent);
+void variable_table_init(struct VariableTable *self, struct Allocator const *allocator);
 void variable_table_free(struct VariableTable *self);
+void variable_table_push_scope(struct VariableTable *self);
+void variable_table_pop_scope(struct VariableTable *self);
+usize variable_table_scope_depth(struct VariableTable const *self);
 struct CompileResult variable_table_update(
     struct VariableTable *self, 
     struct VariableDescription variable_desc,
     struct AstNodePosition position 
 );
-bool variable_table_has(struct VariableTable const *self, struct CharSlice name);
+bool variable_table_has(struct VariableTable const *self, u32 symbol);
 bool variable_table_lookup(
     struct VariableTable const *self, 
-    struct CharSlice name, struct VariableDescription *out
+    u32 symbol, 
+    struct VariableDescription *out
 ); 
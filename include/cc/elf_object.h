@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/compile/encoder.h"
+#include "cc/writer.h"
+
+// ELF64 relocatable object files (x86-64) for the machine code of compile_code, in place of
+// assembling the text output with nasm
+
+// The sections of one translation unit
+// Every label becomes a global symbol (C functions have external linkage), and the fixups left in
+// `text` become calls to undefined symbols, relocated through the PLT
+struct ObjectSections {
+    struct CodeBuffer const *text;
+    struct CodeBuffer const *data;
+    // may be NULL if there is no read-only data
+    struct CodeBuffer const *rodata;
+    usize bss_len;
+};
+
+// writes .text, .data, .rodata, .bss, .note.GNU-stack, .symtab, .strtab, .rela.text and .shstrtab
+void elf_write_object(struct Writer *writer, struct ObjectSections const *sections);
@@ -6,6 +6,7 @@
 
 struct FunctionParameter {
     struct CharSlice name;
+    u32 symbol;
     struct Type type;
     struct AstNodePosition ast_node_position;
 };
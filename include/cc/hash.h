@@ -2,6 +2,8 @@
 
 #include "cc/slice.h"
 
+// Word-at-a-time hash in the style of wyhash: reads 8 bytes per step and mixes with 64-bit 
+// multiplies, so every input byte affects every output bit
 // Source:
-// http://www.cse.yorku.ca/~oz/hash.html
-usize charslice_hash_djb2(struct CharSlice s);
+// https://github.com/wangyi-fudan/wyhash
+usize charslice_hash(struct CharSlice s);
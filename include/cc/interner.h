@@ -0,0 +1,69 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/slice.h"
+#include "cc/vec.h"
+
+// String interner: maps each distinct identifier to a dense u32 symbol, so symbol tables can 
+// key on the symbol instead of hashing and comparing the bytes on every lookup
+
+struct InternerEntry {
+    usize offset; // offset of the name in `bytes`
+    u32 len;
+    u32 hash;
+};
+
+// declare InternerEntrySlice and InternerEntryVec
+#define SLICE_TYPE InternerEntrySlice 
+#define SLICE_ELEMENT_TYPE struct InternerEntry 
+#define SLICE_FUNCTION_PREFIX internerentryslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE InternerEntryVec 
+#define VEC_ELEMENT_TYPE struct InternerEntry 
+#define VEC_SLICE_TYPE InternerEntrySlice
+#define VEC_FUNCTION_PREFIX internerentryvec_
+#include "cc/template/vec.h"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+struct Interner {
+    // names of all symbols, back to back
+    struct CharVec bytes;
+    // symbol -> name
+    struct InternerEntryVec entries;
+    // open-addressed hash table of symbol + 1 (0 marks an empty slot), size is a power of 2
+    u32 *table;
+    usize table_size;
+};
+
+struct InternerStatistics {
+    usize symbol_count;
+    usize bytes_stored;
+    usize table_size;
+};
+
+void interner_init(struct Interner *self);
+void interner_free(struct Interner *self);
+
+// symbol for `name`, adding it if it has not been seen before
+u32 interner_intern(struct Interner *self, struct CharSlice name);
+// name of a symbol, only valid until the next call to interner_intern
+struct CharSlice interner_name(struct Interner const *self, u32 symbol);
+
+struct InternerStatistics interner_statistics(struct Interner const *self);
+
+// hash and equality for maps keyed on symbols
+static inline usize symbol_hash(u32 const symbol) {
+    // symbols are dense, so spread them with a multiplicative (Fibonacci) hash
+    return (usize) (symbol * 0x9e3779b1u);
+}
+
+static inline bool symbol_eq(u32 const a, u32 const b) {
+    return a == b;
+}
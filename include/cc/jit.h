@@ -0,0 +1,40 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/compile/encoder.h"
+#include "cc/slice.h"
+
+// Runs machine code from compile_code in this process, in place of linking an executable
+// Calls to functions not defined in the code are resolved among the libraries loaded into the
+// process (libc), through a table of stubs placed after the text, since the libraries may be
+// further away than a rel32 call reaches
+
+struct JitProgram {
+    // text, stubs and the entry trampoline (executable), then data (writable), each starting on
+    // a page
+    char *memory;
+    usize len;
+    usize text_len;
+    usize entry_offset;
+    usize executable_len;
+    // labels of the text, which must outlive the program
+    struct CodeBuffer const *text;
+    // jitdump file, which stays mapped so that perf can find it (NULL if none was written)
+    void *jitdump_mapping;
+    usize jitdump_mapping_len;
+};
+
+// returns false (after logging) if a called function cannot be found
+bool jit_load(struct JitProgram *self, struct CodeBuffer const *text, struct CodeBuffer const *data);
+void jit_free(struct JitProgram *self);
+
+// address of a label of the text, NULL if there is none
+void const *jit_symbol(struct JitProgram const *self, struct CharSlice name);
+// calls `main` (which must exist) and returns what it returns
+i32 jit_call_main(struct JitProgram const *self);
+
+// profiling information for perf: /tmp/perf-<pid>.map, a symbol for each function, and
+// /tmp/jit-<pid>.dump, with the code itself (for `perf inject --jit`)
+// both return false (after logging) if the file cannot be written
+bool jit_write_perf_map(struct JitProgram const *self);
+bool jit_write_jitdump(struct JitProgram *self);
@@ -1,6 +1,37 @@
 #pragma once 
 
 #include "cc/common.h"
+#include "cc/interner.h"
+#include "cc/slice.h"
 #include "cc/token.h"
+#include "cc/token_store.h"
 
-struct TokenVec tokenize(char const *source_string);
+struct Lexer {
+    char const *source_string;
+    // source map file ID of the source, stamped on every token position
+    u32 file;
+    // identifiers are interned as they are scanned
+    struct Interner *interner;
+
+    usize character_index;
+};
+
+// the source must be shorter than 4 GiB (see source_map_add_file)
+void lexer_init(
+    struct Lexer *self, 
+    char const *source_string, 
+    u32 file, 
+    struct Interner *interner
+);
+// returns TokenEof once the end of the source is reached
+struct Token lexer_next_token(struct Lexer *self);
+// the keyword token for `word`, or TokenIdentifier if it is not a keyword
+enum TokenKind lexer_keyword_kind(struct CharSlice word);
+
+// lex the whole source at once into a new token store
+void tokenize(
+    struct TokenStore *out, 
+    char const *source_string, 
+    u32 file, 
+    struct Interner *interner
+);
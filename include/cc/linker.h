@@ -0,0 +1,40 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/elf_object.h"
+#include "cc/writer.h"
+
+// Links the sections of translation units straight into an x86-64 ELF executable, in place of
+// writing an object file and running ld
+// The entry point calls `main` and exits with its return value. A program that calls nothing
+// outside of its units is linked statically (and exits with a system call); otherwise the calls
+// are bound at load time by the dynamic linker, through a PLT and GOT, to the functions of
+// `LINK_LIBRARY` (and the program exits through its `exit`, which flushes stdio)
+
+#define LINK_INTERPRETER "/lib64/ld-linux-x86-64.so.2"
+#define LINK_LIBRARY "libc.so.6"
+
+enum LinkMode {
+    // static if there are no external calls, dynamic otherwise
+    LinkAuto,
+    LinkStatic,
+    LinkDynamic,
+};
+
+struct LinkStatistics {
+    usize text_len;
+    usize data_len;
+    // functions imported from the library
+    usize import_count;
+    bool is_dynamic;
+};
+
+// writes the executable for `units`, or logs the undefined or duplicate symbols and returns false
+// (writing nothing)
+bool link_executable(
+    struct Writer *writer,
+    struct ObjectSections const *units,
+    usize unit_count,
+    enum LinkMode mode,
+    struct LinkStatistics *statistics_out
+);
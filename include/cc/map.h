@@ -1,6 +1,7 @@
 #pragma once 
 
 #include "cc/hash.h"
+#include "cc/interner.h"
 #include "cc/slice.h"
 
 #define MAP_TYPE            Map__CharSlice_usize
@@ -8,11 +9,28 @@
 #define MAP_VALUE_TYPE      usize
 #define MAP_FUNCTION_PREFIX map__charslice_usize__
 #define MAP_KEY_EQ_FN       charslice_eq
-#define MAP_KEY_HASH_FN     charslice_hash_djb2
-#include "cc/template/map.h"
+#define MAP_KEY_HASH_FN     charslice_hash
+#include "cc/template/flat_map.h"
 #undef MAP_TYPE            
 #undef MAP_KEY_TYPE 
 #undef MAP_VALUE_TYPE      
 #undef MAP_FUNCTION_PREFIX 
 #undef MAP_KEY_EQ_FN       
 #undef MAP_KEY_HASH_FN     
+
+
+#define MAP_TYPE            Map__u32_usize
+#define MAP_KEY_TYPE        u32
+#define MAP_VALUE_TYPE      usize
+#define MAP_FUNCTION_PREFIX map__u32_usize__
+#define MAP_KEY_EQ_FN       symbol_eq
+#define MAP_KEY_HASH_FN     symbol_hash
+#define MAP_ALLOCATOR
+#include "cc/template/flat_map.h"
+#undef MAP_TYPE            
+#undef MAP_KEY_TYPE 
+#undef MAP_VALUE_TYPE      
+#undef MAP_FUNCTION_PREFIX 
+#undef MAP_KEY_EQ_FN       
+#undef MAP_KEY_HASH_FN     
+#undef MAP_ALLOCATOR
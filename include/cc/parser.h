@@ -2,13 +2,14 @@
 
 #include "cc/arena.h"
 #include "cc/ast.h"
+#include "cc/source_map.h"
 #include "cc/token.h"
+#include "cc/token_stream.h"
 #include "cc/writer.h"
 
 enum ParseErrorKind {
     ParseErrorUnknown,
-    ParseErrorJoin,          // {ParseError} or {ParseError}
-    ParseErrorExpectedToken, // expected {TokenKind}, got {TokenKind}
+    ParseErrorExpectedToken, // expected one of {TokenKind...}, got {TokenKind}
     ParseErrorInvalidIntegerType,
 };
 
@@ -16,13 +17,10 @@ struct ParseError {
     enum ParseErrorKind kind;
 
     union {
-        struct {
-            struct ParseError const *left;
-            struct ParseError const *right;
-        } join;
         struct {
             struct TokenPosition position;
-            enum TokenKind expected;
+            // bit set of the token kinds that would have been accepted
+            u64 expected;
             enum TokenKind got;
         } expected_token;
         struct {
@@ -33,9 +31,26 @@ struct ParseError {
 
 struct ParseResult {
     bool ok;
+    // only filled in by `parse`: rules just report failure, and the error is built from the 
+    // furthest failure once the whole parse has failed
     struct ParseError error;
 };
 
-struct ParseResult parse(struct AstRoot *out, struct TokenSlice tokens, struct Arena *ast_arena);
-void format_parse_error(struct Writer *writer, struct ParseError const *error);
+// how much backtracking the packrat memo table saved
+struct ParseStatistics {
+    usize memo_hits;
+    usize memo_misses;
+};
+
+struct ParseResult parse(
+    struct AstRoot *out, 
+    struct TokenStream *tokens, 
+    struct Arena *ast_arena,
+    struct ParseStatistics *statistics_out
+);
+void format_parse_error(
+    struct Writer *writer, 
+    struct SourceMap *sources, 
+    struct ParseError const *error
+);
 
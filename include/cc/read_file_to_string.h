@@ -1,3 +0,0 @@
-#pragma once 
-
-char *read_file_to_string(char const *path);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "cc/common.h"
+
+// A source file loaded into memory, always followed by a NUL terminator. Regular files are 
+// mapped directly (so tokens and AST identifiers point into the page cache), anything else 
+// (pipes, stdin) is read into a heap buffer
+
+enum SourceBufferKind {
+    SourceBufferKindMapped,
+    SourceBufferKindHeap,
+};
+
+struct SourceBuffer {
+    enum SourceBufferKind kind;
+    char const *data;
+    usize len;
+    // size of the mapping or allocation holding `data`
+    usize capacity;
+};
+
+// load the file at `path`, or stdin if `path` is "-"
+// returns false (with errno set) if the file could not be read
+bool source_buffer_open(struct SourceBuffer *out, char const *path);
+void source_buffer_free(struct SourceBuffer *self);
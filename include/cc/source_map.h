@@ -0,0 +1,42 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/source_buffer.h"
+#include "cc/token.h"
+
+// The source files of a build, numbered in the order they are added. Source positions are 
+// stored as (file, offset) pairs; line and column are only computed for diagnostics, from a 
+// table of line starts built the first time a file is asked for one
+
+struct SourceFile {
+    char const *path;
+    struct SourceBuffer buffer;
+
+    // offset of the first character of each line, built on demand
+    u32 *line_starts;
+    usize line_count;
+};
+
+struct SourceMap {
+    struct SourceFile *files;
+    usize file_count;
+};
+
+// 1-based line and column
+struct SourceLineColumn {
+    usize line;
+    usize column;
+};
+
+void source_map_init(struct SourceMap *self);
+void source_map_free(struct SourceMap *self);
+
+// load a source file (see source_buffer_open), returns false (with errno set) if the file could 
+// not be read or is too large for 32-bit offsets
+bool source_map_add_file(struct SourceMap *self, char const *path, u32 *file_out);
+struct SourceFile const *source_map_file(struct SourceMap const *self, u32 file);
+
+struct SourceLineColumn source_map_line_column(
+    struct SourceMap *self, 
+    struct TokenPosition position
+);
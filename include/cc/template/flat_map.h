@@ -0,0 +1,59 @@
+// Open-addressing hash map, with the same interface as the chained map it replaced
+// (bench/chained_map.h)
+// define
+// MAP_TYPE            | Name for map type e.g. StringIntMap
+// MAP_KEY_TYPE        | Type of keys e.g. char const *
+// MAP_VALUE_TYPE      | Type of values e.g. int
+// MAP_FUNCTION_PREFIX | Prefix for functions on the map, e.g. stringintmap_
+// MAP_KEY_HASH_FN     | Hash function for keys   (MAP_KEY_TYPE -> usize)
+// MAP_KEY_EQ_FN       | Equality function for keys (MAP_KEY_TYPE, MAP_KEY_TYPE -> bool)
+// MAP_ALLOCATOR       | (Optional) if defined, the map allocates through a struct Allocator
+//                     | given to init_in (init uses heap_allocator)
+
+#include "cc/common.h"
+
+#ifdef MAP_ALLOCATOR
+    #include "cc/allocator.h"
+#endif
+
+#define MAP_CONCAT1(a, b) a##b
+#define MAP_CONCAT2(a, b) MAP_CONCAT1(a, b)
+#define MAP_PREFIX(function) MAP_CONCAT2(MAP_FUNCTION_PREFIX, function)
+
+struct MAP_PREFIX(Slot) {
+    MAP_KEY_TYPE key;
+    MAP_VALUE_TYPE value;
+    // cached (mixed) hash of the key, so that growing the table does not rehash keys
+    usize hash;
+};
+
+struct MAP_TYPE {
+    // Number of slots in the table (a power of two)
+    usize capacity;
+    // Number of key/value pairs in the map
+    usize element_count;
+    // Number of slots whose key was removed
+    usize deleted_count;
+    // Control byte for each slot, followed by copies of the first FLAT_MAP_GROUP_LEN control
+    // bytes so that a group can be loaded at any slot without wrapping
+    u8 *controls;
+    struct MAP_PREFIX(Slot) *slots;
+#ifdef MAP_ALLOCATOR
+    struct Allocator const *allocator;
+#endif
+};
+
+void            MAP_PREFIX(init)        (struct MAP_TYPE *self, usize table_size);
+#ifdef MAP_ALLOCATOR
+void            MAP_PREFIX(init_in)     (struct MAP_TYPE *self, usize table_size, struct Allocator const *allocator);
+#endif
+void            MAP_PREFIX(clone)       (struct MAP_TYPE *self, struct MAP_TYPE const *other);
+void            MAP_PREFIX(free)        (struct MAP_TYPE *self);
+MAP_VALUE_TYPE *MAP_PREFIX(get)         (struct MAP_TYPE const *self, MAP_KEY_TYPE key);
+bool            MAP_PREFIX(contains_key)(struct MAP_TYPE const *self, MAP_KEY_TYPE key);
+void            MAP_PREFIX(set)         (struct MAP_TYPE *self, MAP_KEY_TYPE key, MAP_VALUE_TYPE value);
+bool            MAP_PREFIX(remove)      (struct MAP_TYPE *self, MAP_KEY_TYPE key);
+
+#undef MAP_CONCAT1
+#undef MAP_CONCAT2
+#undef MAP_PREFIX
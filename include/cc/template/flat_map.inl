@@ -0,0 +1,284 @@
+// Open-addressing hash map, with the same interface as the chained map it replaced
+// (bench/chained_map.h)
+// define
+// MAP_TYPE            | Name for map type e.g. StringIntMap
+// MAP_KEY_TYPE        | Type of keys e.g. char const *
+// MAP_VALUE_TYPE      | Type of values e.g. int
+// MAP_FUNCTION_PREFIX | Prefix for functions on the map, e.g. stringintmap_
+// MAP_KEY_HASH_FN     | Hash function for keys   (MAP_KEY_TYPE -> usize)
+// MAP_KEY_EQ_FN       | Equality function for keys (MAP_KEY_TYPE, MAP_KEY_TYPE -> bool)
+// MAP_ALLOCATOR       | (Optional) if defined, the map allocates through a struct Allocator
+//                     | given to init_in (init uses heap_allocator)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/log.h"
+#include "cc/template/flat_map_group.h"
+
+#define MAP_CONCAT1(a, b) a##b
+#define MAP_CONCAT2(a, b) MAP_CONCAT1(a, b)
+#define MAP_PREFIX(function) MAP_CONCAT2(MAP_FUNCTION_PREFIX, function)
+
+#ifdef MAP_ALLOCATOR
+    #define MAP_SET_ALLOCATOR(self, allocator_) ((self)->allocator = (allocator_))
+    #define MAP_ALLOC(self, len) allocator_alloc((self)->allocator, (len))
+    #define MAP_FREE(self, ptr, len) allocator_free((self)->allocator, (ptr), (len))
+#else
+    #define MAP_SET_ALLOCATOR(self, allocator_) ((void) 0)
+    #define MAP_ALLOC(self, len) malloc(len)
+    #define MAP_FREE(self, ptr, len) free(ptr)
+#endif
+
+// Slots are probed a group at a time, starting at the group given by the hash and moving on by
+// one more group each time (triangular probing, which visits every group of a power-of-two
+// table). A key is absent once a group with an empty slot has been searched, and the table is
+// grown before the last empty slots are used up (load factor 7/8, counting deleted slots)
+
+// the allocator of `self` must already be set
+static void MAP_PREFIX(alloc_table)(struct MAP_TYPE *const self, usize const capacity) {
+    self->capacity      = capacity;
+    self->element_count = 0u;
+    self->deleted_count = 0u;
+    self->controls      = MAP_ALLOC(self, capacity + FLAT_MAP_GROUP_LEN);
+    self->slots         = MAP_ALLOC(self, capacity * sizeof (struct MAP_PREFIX(Slot)));
+
+    if (self->controls == NULL || self->slots == NULL) {
+        log_error("map: cannot allocate table of %zu slots", capacity);
+        exit(1);
+    }
+
+    memset(self->controls, FLAT_MAP_CONTROL_EMPTY, capacity + FLAT_MAP_GROUP_LEN);
+}
+
+static void MAP_PREFIX(set_control)(
+    struct MAP_TYPE *const self,
+    usize const index,
+    u8 const control
+) {
+    self->controls[index] = control;
+
+    // keep the copy of the first group's control bytes at the end of the table in sync
+    if (index < FLAT_MAP_GROUP_LEN) {
+        self->controls[self->capacity + index] = control;
+    }
+}
+
+// index of the slot holding `key`, or `capacity` if there is none
+static usize MAP_PREFIX(find)(
+    struct MAP_TYPE const *const self,
+    MAP_KEY_TYPE const key,
+    usize const hash
+) {
+    usize const mask = self->capacity - 1u;
+    u8 const control = flat_map_control_of_hash(hash);
+    usize position = (hash >> 7u) & mask;
+    usize stride = 0u;
+
+    for (;;) {
+        u8 const *const group = self->controls + position;
+
+        u32 matches = flat_map_group_match(group, control);
+        while (matches != 0u) {
+            usize const index = (position + (usize) __builtin_ctz(matches)) & mask;
+            struct MAP_PREFIX(Slot) const *const slot = &self->slots[index];
+
+            if (slot->hash == hash && MAP_KEY_EQ_FN(key, slot->key)) {
+                return index;
+            }
+
+            matches &= matches - 1u;
+        }
+
+        if (flat_map_group_match_empty(group) != 0u) {
+            return self->capacity;
+        }
+
+        stride += FLAT_MAP_GROUP_LEN;
+        position = (position + stride) & mask;
+    }
+}
+
+// index of the first slot without a key on the probe sequence of `hash`
+static usize MAP_PREFIX(find_free)(struct MAP_TYPE const *const self, usize const hash) {
+    usize const mask = self->capacity - 1u;
+    usize position = (hash >> 7u) & mask;
+    usize stride = 0u;
+
+    for (;;) {
+        u32 const free_slots = flat_map_group_match_free(self->controls + position);
+
+        if (free_slots != 0u) {
+            return (position + (usize) __builtin_ctz(free_slots)) & mask;
+        }
+
+        stride += FLAT_MAP_GROUP_LEN;
+        position = (position + stride) & mask;
+    }
+}
+
+// moves every key to a new table of `capacity` slots, dropping deleted slots
+static void MAP_PREFIX(rehash)(struct MAP_TYPE *const self, usize const capacity) {
+    struct MAP_TYPE old = *self;
+    MAP_PREFIX(alloc_table)(self, capacity);
+
+    for (usize index = 0u; index < old.capacity; index += 1u) {
+        if ((old.controls[index] & 0x80u) != 0u) {
+            continue;
+        }
+
+        struct MAP_PREFIX(Slot) const *const slot = &old.slots[index];
+        usize const new_index = MAP_PREFIX(find_free)(self, slot->hash);
+
+        MAP_PREFIX(set_control)(self, new_index, old.controls[index]);
+        self->slots[new_index] = *slot;
+        self->element_count += 1u;
+    }
+
+    MAP_PREFIX(free)(&old);
+}
+
+static usize MAP_PREFIX(initial_capacity)(usize const table_size) {
+    usize capacity = FLAT_MAP_GROUP_LEN;
+    while (capacity < table_size) {
+        capacity *= 2u;
+    }
+
+    return capacity;
+}
+
+// `table_size` is the initial number of slots, rounded up to a power of two
+void MAP_PREFIX(init)(
+    struct MAP_TYPE *const self,
+    usize const table_size
+) {
+    MAP_SET_ALLOCATOR(self, &heap_allocator);
+    MAP_PREFIX(alloc_table)(self, MAP_PREFIX(initial_capacity)(table_size));
+}
+
+#ifdef MAP_ALLOCATOR
+void MAP_PREFIX(init_in)(
+    struct MAP_TYPE *const self,
+    usize const table_size,
+    struct Allocator const *const allocator
+) {
+    self->allocator = allocator;
+    MAP_PREFIX(alloc_table)(self, MAP_PREFIX(initial_capacity)(table_size));
+}
+#endif
+
+void MAP_PREFIX(clone)(
+    struct MAP_TYPE *const self,
+    struct MAP_TYPE const *const other
+) {
+    MAP_SET_ALLOCATOR(self, other->allocator);
+    MAP_PREFIX(alloc_table)(self, other->capacity);
+    self->element_count = other->element_count;
+    self->deleted_count = other->deleted_count;
+
+    memcpy(self->controls, other->controls, other->capacity + FLAT_MAP_GROUP_LEN);
+    memcpy(self->slots, other->slots, other->capacity * sizeof (struct MAP_PREFIX(Slot)));
+}
+
+void MAP_PREFIX(free)(
+    struct MAP_TYPE *const self
+) {
+    MAP_FREE(self, self->controls, self->capacity + FLAT_MAP_GROUP_LEN);
+    MAP_FREE(self, self->slots, self->capacity * sizeof (struct MAP_PREFIX(Slot)));
+}
+
+MAP_VALUE_TYPE *MAP_PREFIX(get)(
+    struct MAP_TYPE const *const self,
+    MAP_KEY_TYPE const key
+) {
+    usize const index = MAP_PREFIX(find)(self, key, flat_map_mix_hash(MAP_KEY_HASH_FN(key)));
+
+    if (index == self->capacity) {
+        return NULL;
+    }
+
+    return &self->slots[index].value;
+}
+
+bool MAP_PREFIX(contains_key)(
+    struct MAP_TYPE const *const self,
+    MAP_KEY_TYPE const key
+) {
+    return MAP_PREFIX(find)(self, key, flat_map_mix_hash(MAP_KEY_HASH_FN(key))) != self->capacity;
+}
+
+void MAP_PREFIX(set)(
+    struct MAP_TYPE *const self,
+    MAP_KEY_TYPE const key,
+    MAP_VALUE_TYPE const value
+) {
+    usize const hash = flat_map_mix_hash(MAP_KEY_HASH_FN(key));
+    usize index = MAP_PREFIX(find)(self, key, hash);
+
+    if (index != self->capacity) {
+        self->slots[index].value = value;
+        return;
+    }
+
+    // grow before the table is more than 7/8 full, or just clear out deleted slots if they are
+    // what fills it
+    if ((self->element_count + self->deleted_count + 1u) * 8u > self->capacity * 7u) {
+        usize const capacity = (self->element_count + 1u) * 2u > self->capacity
+            ? self->capacity * 2u
+            : self->capacity;
+        MAP_PREFIX(rehash)(self, capacity);
+    }
+
+    index = MAP_PREFIX(find_free)(self, hash);
+    if (self->controls[index] == FLAT_MAP_CONTROL_DELETED) {
+        self->deleted_count -= 1u;
+    }
+
+    MAP_PREFIX(set_control)(self, index, flat_map_control_of_hash(hash));
+    self->slots[index] = (struct MAP_PREFIX(Slot)) {
+        .key = key,
+        .value = value,
+        .hash = hash,
+    };
+    self->element_count += 1u;
+}
+
+bool MAP_PREFIX(remove)(
+    struct MAP_TYPE *const self,
+    MAP_KEY_TYPE const key
+) {
+    usize const index = MAP_PREFIX(find)(self, key, flat_map_mix_hash(MAP_KEY_HASH_FN(key)));
+
+    if (index == self->capacity) {
+        return false;
+    }
+
+    // the slot may be on the probe sequence of other keys, so it can only be marked empty if
+    // no group containing it has ever been full, in which case no probe went past it: that is,
+    // if the run of used slots around it is shorter than a group
+    u32 const empty_before = flat_map_group_match_empty(
+        self->controls + ((index - FLAT_MAP_GROUP_LEN) & (self->capacity - 1u))
+    );
+    u32 const empty_after = flat_map_group_match_empty(self->controls + index);
+    bool const is_probe_end = empty_before != 0u
+        && empty_after != 0u
+        && (usize) __builtin_ctz(empty_after) + (usize) (__builtin_clz(empty_before) - 16)
+            < FLAT_MAP_GROUP_LEN;
+
+    if (is_probe_end) {
+        MAP_PREFIX(set_control)(self, index, FLAT_MAP_CONTROL_EMPTY);
+    } else {
+        MAP_PREFIX(set_control)(self, index, FLAT_MAP_CONTROL_DELETED);
+        self->deleted_count += 1u;
+    }
+    self->element_count -= 1u;
+
+    return true;
+}
+
+#undef MAP_SET_ALLOCATOR
+#undef MAP_ALLOC
+#undef MAP_FREE
+#undef MAP_CONCAT1
+#undef MAP_CONCAT2
+#undef MAP_PREFIX
@@ -0,0 +1,60 @@
+#pragma once
+
+// Control bytes of the open-addressing map template (flat_map.h), shared by all of its
+// instantiations
+// Every slot of the table has a control byte: either one of the two special values below, or
+// the low 7 bits of the hash of the key stored in the slot. Probing compares a group of 16
+// control bytes at once
+
+#include "cc/common.h"
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#define FLAT_MAP_GROUP_LEN 16u
+
+#define FLAT_MAP_CONTROL_EMPTY   ((u8) 0x80u)
+#define FLAT_MAP_CONTROL_DELETED ((u8) 0xfeu)
+
+// bit i is set if control byte i of the group equals `control`
+static inline u32 flat_map_group_match(u8 const *const group, u8 const control) {
+#ifdef __SSE2__
+    __m128i const controls = _mm_loadu_si128((__m128i const *) group);
+    return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8((char) control)));
+#else
+    u32 mask = 0u;
+    for (usize i = 0u; i < FLAT_MAP_GROUP_LEN; i += 1u) {
+        mask |= (u32) (group[i] == control) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline u32 flat_map_group_match_empty(u8 const *const group) {
+    return flat_map_group_match(group, FLAT_MAP_CONTROL_EMPTY);
+}
+
+// bit i is set if slot i of the group holds no key (both special values have the top bit set)
+static inline u32 flat_map_group_match_free(u8 const *const group) {
+#ifdef __SSE2__
+    return (u32) _mm_movemask_epi8(_mm_loadu_si128((__m128i const *) group));
+#else
+    u32 mask = 0u;
+    for (usize i = 0u; i < FLAT_MAP_GROUP_LEN; i += 1u) {
+        mask |= (u32) (group[i] >> 7u) << i;
+    }
+    return mask;
+#endif
+}
+
+// spreads the bits of a key hash over the whole word, so that keys hashed to consecutive
+// integers (or to multiples of a power of two) land in different groups
+static inline usize flat_map_mix_hash(usize const hash) {
+    u64 const mixed = (u64) hash * 0x9e3779b97f4a7c15u;
+    return (usize) (mixed ^ (mixed >> 32u));
+}
+
+static inline u8 flat_map_control_of_hash(usize const hash) {
+    return (u8) (hash & 0x7fu);
+}
@@ -0,0 +1,38 @@
+// Vec with room for a few elements inside the struct itself, which only allocates once it 
+// outgrows them. For short-lived vecs that are usually short
+// define 
+// SMALLVEC_TYPE            | Name for vec type e.g. ExpressionSmallVec
+// SMALLVEC_ELEMENT_TYPE    | Type of vec elements e.g. struct AstExpression
+// SMALLVEC_INLINE_CAPACITY | Number of elements stored inline e.g. 8
+// SMALLVEC_SLICE_TYPE      | Corresponding slice e.g. ExpressionSlice
+// SMALLVEC_FUNCTION_PREFIX | Prefix for functions on the vec, e.g. expressionsmallvec_
+
+#include "cc/common.h"
+
+#define SMALLVEC_CONCAT1(a, b) a##b
+#define SMALLVEC_CONCAT2(a, b) SMALLVEC_CONCAT1(a, b)
+#define SMALLVEC_PREFIX(function) SMALLVEC_CONCAT2(SMALLVEC_FUNCTION_PREFIX, function)
+
+struct SMALLVEC_TYPE {
+    usize len;
+    usize capacity;
+    // NULL while the elements fit in `inline_data`
+    // (the vec does not point into itself, so it can be copied like any other struct)
+    SMALLVEC_ELEMENT_TYPE *heap_data;
+    SMALLVEC_ELEMENT_TYPE inline_data[SMALLVEC_INLINE_CAPACITY];
+};
+
+void                       SMALLVEC_PREFIX(init)       (struct SMALLVEC_TYPE *self);
+void                       SMALLVEC_PREFIX(free)       (struct SMALLVEC_TYPE *self);
+SMALLVEC_ELEMENT_TYPE     *SMALLVEC_PREFIX(data)       (struct SMALLVEC_TYPE const *self);
+SMALLVEC_ELEMENT_TYPE     *SMALLVEC_PREFIX(at)         (struct SMALLVEC_TYPE const *self, usize index);
+SMALLVEC_ELEMENT_TYPE     *SMALLVEC_PREFIX(peek_back)  (struct SMALLVEC_TYPE const *self);
+struct SMALLVEC_SLICE_TYPE SMALLVEC_PREFIX(slice_whole)(struct SMALLVEC_TYPE const *self);
+void                       SMALLVEC_PREFIX(reserve)    (struct SMALLVEC_TYPE *self, usize n);
+void                       SMALLVEC_PREFIX(push)       (struct SMALLVEC_TYPE *self, SMALLVEC_ELEMENT_TYPE el);
+SMALLVEC_ELEMENT_TYPE      SMALLVEC_PREFIX(pop_back)   (struct SMALLVEC_TYPE *self);
+void                       SMALLVEC_PREFIX(clear)      (struct SMALLVEC_TYPE *self);
+
+#undef SMALLVEC_CONCAT1
+#undef SMALLVEC_CONCAT2
+#undef SMALLVEC_PREFIX
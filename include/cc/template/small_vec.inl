@@ -0,0 +1,111 @@
+// define 
+// SMALLVEC_TYPE            | Name for vec type e.g. ExpressionSmallVec
+// SMALLVEC_ELEMENT_TYPE    | Type of vec elements e.g. struct AstExpression
+// SMALLVEC_INLINE_CAPACITY | Number of elements stored inline e.g. 8
+// SMALLVEC_SLICE_TYPE      | Corresponding slice e.g. ExpressionSlice
+// SMALLVEC_FUNCTION_PREFIX | Prefix for functions on the vec, e.g. expressionsmallvec_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/log.h"
+
+#define SMALLVEC_CONCAT1(a, b) a##b
+#define SMALLVEC_CONCAT2(a, b) SMALLVEC_CONCAT1(a, b)
+#define SMALLVEC_PREFIX(function) SMALLVEC_CONCAT2(SMALLVEC_FUNCTION_PREFIX, function)
+
+void SMALLVEC_PREFIX(init)(struct SMALLVEC_TYPE *const self) {
+    self->len = 0u;
+    self->capacity = SMALLVEC_INLINE_CAPACITY;
+    self->heap_data = NULL;
+}
+
+void SMALLVEC_PREFIX(free)(struct SMALLVEC_TYPE *const self) {
+    free(self->heap_data);
+}
+
+SMALLVEC_ELEMENT_TYPE *SMALLVEC_PREFIX(data)(struct SMALLVEC_TYPE const *const self) {
+    // like the other vec accessors, a const vec still hands out mutable elements
+    return (self->heap_data != NULL) 
+        ? self->heap_data 
+        : (SMALLVEC_ELEMENT_TYPE *) self->inline_data;
+}
+
+SMALLVEC_ELEMENT_TYPE *SMALLVEC_PREFIX(at)(struct SMALLVEC_TYPE const *const self, usize const index) {
+    if (index < self->len) {
+        return &SMALLVEC_PREFIX(data)(self)[index];
+    } else {
+        log_error("smallvec_at: index out of range (index = %zu, length = %zu)", index, self->len);
+        exit(1);
+    }
+}
+
+SMALLVEC_ELEMENT_TYPE *SMALLVEC_PREFIX(peek_back)(struct SMALLVEC_TYPE const *const self) {
+    if (self->len > 0u) {
+        return &SMALLVEC_PREFIX(data)(self)[self->len - 1u];
+    } else {
+        log_error("smallvec_peek_back: vec is empty");
+        exit(1);
+    }
+}
+
+struct SMALLVEC_SLICE_TYPE SMALLVEC_PREFIX(slice_whole)(struct SMALLVEC_TYPE const *const self) {
+    return (struct SMALLVEC_SLICE_TYPE) {
+        .ptr = SMALLVEC_PREFIX(data)(self),
+        .len = self->len,
+    };
+}
+
+// makes room for `n` more elements, moving them to the heap the first time they do not fit 
+// inline. The capacity at least doubles each time it grows
+void SMALLVEC_PREFIX(reserve)(struct SMALLVEC_TYPE *const self, usize const n) {
+    usize const min_capacity = self->len + n;
+
+    if (min_capacity <= self->capacity) {
+        return;
+    }
+
+    usize const new_capacity = max_usize(min_capacity, self->capacity * 2u);
+    SMALLVEC_ELEMENT_TYPE *const data = (SMALLVEC_ELEMENT_TYPE *) realloc(
+        self->heap_data, 
+        new_capacity * sizeof (SMALLVEC_ELEMENT_TYPE)
+    );
+    if (data == NULL) {
+        log_error("smallvec_reserve: out of memory (desired capacity = %zu)", new_capacity);
+        exit(1);
+    }
+
+    if (self->heap_data == NULL) {
+        memcpy(data, self->inline_data, self->len * sizeof (SMALLVEC_ELEMENT_TYPE));
+    }
+
+    self->heap_data = data;
+    self->capacity = new_capacity;
+}
+
+void SMALLVEC_PREFIX(push)(struct SMALLVEC_TYPE *const self, SMALLVEC_ELEMENT_TYPE const el) {
+    if (self->len == self->capacity) {
+        SMALLVEC_PREFIX(reserve)(self, 1u);
+    }
+
+    SMALLVEC_PREFIX(data)(self)[self->len] = el;
+    self->len += 1u;
+}
+
+SMALLVEC_ELEMENT_TYPE SMALLVEC_PREFIX(pop_back)(struct SMALLVEC_TYPE *const self) {
+    if (self->len > 0u) {
+        self->len -= 1u;
+        return SMALLVEC_PREFIX(data)(self)[self->len];
+    } else {
+        log_error("smallvec_pop_back: vec is empty");
+        exit(1);
+    }
+}
+
+void SMALLVEC_PREFIX(clear)(struct SMALLVEC_TYPE *const self) {
+    self->len = 0u;
+}
+
+#undef SMALLVEC_CONCAT1
+#undef SMALLVEC_CONCAT2
+#undef SMALLVEC_PREFIX
@@ -4,9 +4,15 @@
 // VEC_SLICE_TYPE      | Corresponding slice e.g. CharSlice
 // VEC_FUNCTION_PREFIX | Prefix for functions on the slice, e.g. charvec_
 // VEC_DEBUG_FN        | (Optional) function to print an element of the vec
+// VEC_ALLOCATOR       | (Optional) if defined, the vec allocates through a struct Allocator 
+//                     | given to init_in (init and the other constructors use heap_allocator)
 
 #include "cc/common.h"
 
+#ifdef VEC_ALLOCATOR
+    #include "cc/allocator.h"
+#endif
+
 #define VEC_CONCAT1(a, b) a##b
 #define VEC_CONCAT2(a, b) VEC_CONCAT1(a, b)
 #define VEC_PREFIX(function) VEC_CONCAT2(VEC_FUNCTION_PREFIX, function)
@@ -17,9 +23,15 @@ struct VEC_TYPE {
     usize len;
     usize capacity;
     VEC_ELEMENT_TYPE *data; 
+#ifdef VEC_ALLOCATOR
+    struct Allocator const *allocator;
+#endif
 };
 
 void                     VEC_PREFIX(init)              (struct VEC_TYPE *self);
+#ifdef VEC_ALLOCATOR
+void                     VEC_PREFIX(init_in)           (struct VEC_TYPE *self, struct Allocator const *allocator);
+#endif
 void                     VEC_PREFIX(init_with_capacity)(struct VEC_TYPE *self, usize capacity);
 void                     VEC_PREFIX(clone)             (struct VEC_TYPE *self, struct VEC_TYPE const *other);
 void                     VEC_PREFIX(init_from_slice)   (struct VEC_TYPE *self, struct VEC_SLICE_TYPE slice);
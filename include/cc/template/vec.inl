@@ -3,6 +3,7 @@
 // VEC_ELEMENT_TYPE    | Type of slice elements e.g. char
 // VEC_SLICE_TYPE      | Corresponding slice e.g. CharSlice
 // VEC_FUNCTION_PREFIX | VEC_PREFIX for functions on the slice, e.g. charvec_
+// VEC_ALLOCATOR       | (Optional) allocate through self->allocator instead of malloc
 
 #include <stdlib.h>
 #include <string.h>
@@ -13,38 +14,69 @@
 #define VEC_CONCAT2(a, b) VEC_CONCAT1(a, b)
 #define VEC_PREFIX(function) VEC_CONCAT2(VEC_FUNCTION_PREFIX, function)
 
+// capacity of the first allocation of a vec that grows from empty
+#define VEC_MIN_CAPACITY 8u
+
+#ifdef VEC_ALLOCATOR
+    #define VEC_SET_ALLOCATOR(self, allocator_) ((self)->allocator = (allocator_))
+    #define VEC_ALLOC(self, len) allocator_alloc((self)->allocator, (len))
+    #define VEC_REALLOC(self, ptr, old_len, new_len) \
+        allocator_realloc((self)->allocator, (ptr), (old_len), (new_len))
+    #define VEC_FREE(self, ptr, len) allocator_free((self)->allocator, (ptr), (len))
+#else
+    #define VEC_SET_ALLOCATOR(self, allocator_) ((void) 0)
+    #define VEC_ALLOC(self, len) malloc(len)
+    #define VEC_REALLOC(self, ptr, old_len, new_len) realloc((ptr), (new_len))
+    #define VEC_FREE(self, ptr, len) free(ptr)
+#endif
+
 void VEC_PREFIX(init)(struct VEC_TYPE *const self) {
     self->len = 0u;
     self->capacity = 0u;
+    VEC_SET_ALLOCATOR(self, &heap_allocator);
 
     self->data = (VEC_ELEMENT_TYPE *) NULL;
 }
 
+#ifdef VEC_ALLOCATOR
+void VEC_PREFIX(init_in)(struct VEC_TYPE *const self, struct Allocator const *const allocator) {
+    self->len = 0u;
+    self->capacity = 0u;
+    self->allocator = allocator;
+
+    self->data = (VEC_ELEMENT_TYPE *) NULL;
+}
+#endif
+
 void VEC_PREFIX(init_with_capacity)(struct VEC_TYPE *const self, usize const capacity) {
     self->len = 0u;
     self->capacity = capacity;
+    VEC_SET_ALLOCATOR(self, &heap_allocator);
 
-    self->data = (VEC_ELEMENT_TYPE *) malloc(sizeof (VEC_ELEMENT_TYPE) * capacity);
+    self->data = (VEC_ELEMENT_TYPE *) VEC_ALLOC(self, sizeof (VEC_ELEMENT_TYPE) * capacity);
 }
 
+// the clone uses the same allocator as `other`
 void VEC_PREFIX(init_clone)(struct VEC_TYPE *const self, struct VEC_TYPE const *const other) {
     self->len = other->len;
     self->capacity = other->len;
+    VEC_SET_ALLOCATOR(self, other->allocator);
 
-    self->data = (VEC_ELEMENT_TYPE *) malloc(sizeof (VEC_ELEMENT_TYPE) * self->capacity);
+    self->data = (VEC_ELEMENT_TYPE *) VEC_ALLOC(self, sizeof (VEC_ELEMENT_TYPE) * self->capacity);
     memcpy(self->data, other->data, sizeof (VEC_ELEMENT_TYPE) * self->len);
 }
 
 void VEC_PREFIX(init_from_slice)(struct VEC_TYPE *const self, struct VEC_SLICE_TYPE const slice) {
     self->len = slice.len;
     self->capacity = slice.len;
+    VEC_SET_ALLOCATOR(self, &heap_allocator);
 
-    self->data = (VEC_ELEMENT_TYPE *) malloc(sizeof (VEC_ELEMENT_TYPE) * self->capacity);
+    self->data = (VEC_ELEMENT_TYPE *) VEC_ALLOC(self, sizeof (VEC_ELEMENT_TYPE) * self->capacity);
     memcpy(self->data, slice.ptr, sizeof (VEC_ELEMENT_TYPE) * slice.len);
 }
 
 void VEC_PREFIX(free)(struct VEC_TYPE *const self) {
-    free(self->data);
+    VEC_FREE(self, self->data, self->capacity * sizeof (VEC_ELEMENT_TYPE));
 }
 
 VEC_ELEMENT_TYPE *VEC_PREFIX(at)(struct VEC_TYPE const *const self, usize const index) {
@@ -94,18 +126,30 @@ void VEC_PREFIX(resize)(struct VEC_TYPE *const self, usize const new_capacity) {
         exit(1);
     }
 
-    if (self->data == NULL) {
-        self->data = (VEC_ELEMENT_TYPE *) malloc(new_capacity * sizeof (VEC_ELEMENT_TYPE));
-    } else {
-        self->data = (VEC_ELEMENT_TYPE *) realloc(self->data, new_capacity * sizeof (VEC_ELEMENT_TYPE));
+    VEC_ELEMENT_TYPE *const data = (VEC_ELEMENT_TYPE *) VEC_REALLOC(
+        self, 
+        self->data, 
+        self->capacity * sizeof (VEC_ELEMENT_TYPE), 
+        new_capacity * sizeof (VEC_ELEMENT_TYPE)
+    );
+    if (data == NULL && new_capacity != 0u) {
+        log_error("vec_resize: out of memory (desired capacity = %zu)", new_capacity);
+        exit(1);
     }
+
+    self->data = data;
+    self->capacity = new_capacity;
 }
 
+// makes room for `n` more elements
+// the capacity at least doubles each time it grows, so a sequence of pushes takes amortized 
+// constant time
 void VEC_PREFIX(reserve)(struct VEC_TYPE *const self, usize const n) {
-    usize min_capacity = self->len + n;
+    usize const min_capacity = self->len + n;
 
     if (min_capacity > self->capacity) {
-        VEC_PREFIX(resize)(self, (min_capacity * 3u) / 2u);
+        usize const doubled_capacity = max_usize(self->capacity * 2u, VEC_MIN_CAPACITY);
+        VEC_PREFIX(resize)(self, max_usize(min_capacity, doubled_capacity));
     }
 }
 
@@ -147,7 +191,7 @@ void VEC_PREFIX(insert_slice)(struct VEC_TYPE *const self, usize const index, st
 
     VEC_PREFIX(reserve)(self, slice.len);
     memmove(
-        self->data + index, 
+        self->data + index + slice.len, 
         self->data + index, 
         (self->len - index) * sizeof (VEC_ELEMENT_TYPE)
     );
@@ -161,10 +205,14 @@ void VEC_PREFIX(remove_at)(struct VEC_TYPE *const self, usize const index) {
         exit(1);
     }
 
-    memmove(self->data + index, self->data + index + 1, (self->len - index) * sizeof (VEC_ELEMENT_TYPE));
+    memmove(self->data + index, self->data + index + 1, (self->len - index - 1u) * sizeof (VEC_ELEMENT_TYPE));
     self->len -= 1u;
 }
 
+void VEC_PREFIX(clear)(struct VEC_TYPE *const self) {
+    self->len = 0u;
+}
+
 VEC_ELEMENT_TYPE VEC_PREFIX(pop_back)(struct VEC_TYPE *const self) {
     if (self->len > 0u) {
         self->len -= 1u;
@@ -187,7 +235,7 @@ void VEC_PREFIX(remove_range)(struct VEC_TYPE *const self, usize begin, usize en
 
     usize const n = end - begin;
 
-    memmove(self->data + begin, self->data + begin + n, (self->len - begin) * sizeof (VEC_ELEMENT_TYPE));
+    memmove(self->data + begin, self->data + end, (self->len - end) * sizeof (VEC_ELEMENT_TYPE));
     self->len -= n;
 }
 
@@ -206,6 +254,11 @@ void VEC_PREFIX(debug)(struct Writer *const writer, struct VEC_TYPE const *const
 #endif
 
 
+#undef VEC_MIN_CAPACITY
+#undef VEC_SET_ALLOCATOR
+#undef VEC_ALLOC
+#undef VEC_REALLOC
+#undef VEC_FREE
 #undef VEC_CONCAT1
 #undef VEC_CONCAT2
 #undef VEC_PREFIX
@@ -55,9 +55,11 @@ enum TokenKind {
     TokenCount,
 };
 
+// byte offset into a source file, the source map turns it into a line and column when a 
+// diagnostic needs one
 struct TokenPosition {
-    usize line;
-    usize character;
+    u32 file;
+    u32 offset;
 };
 
 struct Token {
@@ -67,6 +69,7 @@ struct Token {
     union {
         struct {
             struct CharSlice name;
+            u32 symbol;
         } identifier;
         struct {
             u64 value;
@@ -76,6 +79,8 @@ struct Token {
     } variant;
 };
 
+// spelling of the token (for keywords and punctuation) or a description in angle brackets
+char const *token_kind_name(enum TokenKind kind);
 void token_kind_debug(struct Writer *writer, enum TokenKind const *kind);
 void token_debug(struct Writer *writer, struct Token const *token);
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/interner.h"
+#include "cc/token.h"
+
+// Struct-of-arrays token storage: a u8 kind, a u32 source offset and a u32 payload per token. 
+// An identifier's payload is its symbol (its name is read back from the source), an integer's 
+// payload indexes a side table of literal values, other tokens have none. The parser's 
+// lookahead only touches the dense kind array; full tokens are materialized on demand.
+//
+// Tokens are held in ring buffers indexed by absolute token position, so a streaming token 
+// source can release tokens it no longer needs and reuse their space
+
+struct TokenStoreInteger {
+    u64 value;
+    u32 position; // token position of the literal (fewer tokens than source bytes)
+    bool is_long;
+    bool is_signed;
+};
+
+struct TokenStore {
+    char const *source_string;
+    u32 file;
+    struct Interner const *interner;
+
+    // per-token arrays, token i is stored at i & (capacity - 1)
+    u8 *kinds;
+    u32 *offsets;
+    u32 *payloads;
+    usize capacity;
+    // tokens [released, len) are held
+    usize released;
+    usize len;
+
+    // integer literals, literal i is stored at i & (integer_capacity - 1)
+    struct TokenStoreInteger *integers;
+    usize integer_capacity;
+    usize integers_released;
+    usize integer_count;
+};
+
+void token_store_init(
+    struct TokenStore *self, 
+    char const *source_string, 
+    u32 file,
+    struct Interner const *interner
+);
+void token_store_free(struct TokenStore *self);
+
+void token_store_push(struct TokenStore *self, struct Token const *token);
+// drop tokens before `position`
+void token_store_release(struct TokenStore *self, usize position);
+
+// materialize the token at `position`
+struct Token token_store_get(struct TokenStore *self, usize position);
+// bytes allocated for tokens and integer literals
+usize token_store_memory_usage(struct TokenStore const *self);
+
+static inline enum TokenKind token_store_kind(struct TokenStore const *const self, usize const position) {
+    return (enum TokenKind) self->kinds[position & (self->capacity - 1u)];
+}
+
+static inline struct TokenPosition token_store_position(
+    struct TokenStore const *const self, 
+    usize const position
+) {
+    return (struct TokenPosition) {
+        .file = self->file,
+        .offset = self->offsets[position & (self->capacity - 1u)],
+    };
+}
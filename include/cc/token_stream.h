@@ -0,0 +1,49 @@
+#pragma once
+
+#include "cc/common.h"
+#include "cc/lexer.h"
+#include "cc/token.h"
+#include "cc/token_store.h"
+
+// Source of tokens for the parser: either a store of pre-lexed tokens, or a lexer that is 
+// pulled from on demand into a token store holding only the tokens the parser may still read
+
+enum TokenStreamKind {
+    TokenStreamKindStore,
+    TokenStreamKindLexer,
+};
+
+struct TokenStream {
+    enum TokenStreamKind kind;
+
+    union {
+        struct {
+            struct TokenStore *tokens;
+        } store;
+
+        struct {
+            struct Lexer lexer;
+            struct TokenStore tokens;
+            bool reached_eof;
+        } lexer;
+    } variant;
+};
+
+void token_stream_init_store(struct TokenStream *self, struct TokenStore *tokens);
+void token_stream_init_lexer(
+    struct TokenStream *self, 
+    char const *source_string, 
+    u32 file,
+    struct Interner *interner
+);
+void token_stream_free(struct TokenStream *self);
+
+// kind of the token at `position`, or TokenUnknown past the end of the stream
+enum TokenKind token_stream_kind_at(struct TokenStream *self, usize position);
+// source position of the token at `position`, or of the end of the stream past it
+struct TokenPosition token_stream_position_at(struct TokenStream *self, usize position);
+// token at `position`, or TokenUnknown past the end of the stream
+struct Token token_stream_at(struct TokenStream *self, usize position);
+
+// promise that tokens before `position` will not be read again, so their space can be reused
+void token_stream_release(struct TokenStream *self, usize position);
@@ -6,11 +6,13 @@
 #define VEC_ELEMENT_TYPE char 
 #define VEC_SLICE_TYPE CharSlice
 #define VEC_FUNCTION_PREFIX charvec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.h"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
 
 #define VEC_TYPE PtrVec 
@@ -28,9 +30,11 @@
 #define VEC_ELEMENT_TYPE usize
 #define VEC_SLICE_TYPE UsizeSlice
 #define VEC_FUNCTION_PREFIX usizevec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.h"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
@@ -1,16 +1,23 @@
 #pragma once 
 
 #include <stdio.h>
+#include <string.h>
 
+#include "cc/chunk_list.h"
 #include "cc/common.h"
 #include "cc/slice.h"
 #include "cc/vec.h"
 
 // Abstraction for writer to file or string buffer
+// Output is formatted straight into the destination's spare space: the CharVec itself, the last 
+// chunk of a chunk list, or a buffer owned by a file writer, which reaches the file on 
+// `writer_flush` (or when the buffer fills up). A file writer must not be copied, and must be 
+// released with `writer_free`
 
 enum WriterKind {
     WriterKindFile,
     WriterKindCharVec,
+    WriterKindChunkList,
 };
 
 struct Writer {
@@ -19,18 +26,60 @@ struct Writer {
     union {
         struct {
             FILE *file;
+            // output not yet passed to `file`
+            char *buffer;
+            usize len;
         } file;
 
         struct {
             struct CharVec *buffer;
         } charvec;
+
+        struct {
+            struct ChunkList *chunks;
+        } chunk_list;
+    } variant;
+};
+
+// bytes set aside by `writer_reserve`
+struct WriterPlaceholder {
+    enum WriterKind kind;
+
+    union {
+        struct {
+            usize offset;
+            usize len;
+        } charvec;
+
+        struct ChunkPlaceholder chunk_list;
     } variant;
 };
 
 struct Writer file_writer(FILE *file);
 struct Writer charvec_writer(struct CharVec *buffer);
+struct Writer chunk_list_writer(struct ChunkList *chunks);
+// flushes a file writer and releases its buffer (the file stays open)
+void writer_free(struct Writer *self);
+// passes buffered output on to the file, does nothing for other writers
+void writer_flush(struct Writer *self);
+
+void writer_write_bytes(struct Writer *self, char const *bytes, usize len);
+void writer_write_char(struct Writer *self, char c);
+void writer_write_u64(struct Writer *self, u64 value);
+void writer_write_i64(struct Writer *self, i64 value);
+void writer_writef(struct Writer *self, char const *format_string, ...) ATTRIBUTE_PRINTF_LIKE(2, 3);
+
+// sets aside `len` bytes of output, to be filled in with `writer_patch` once they are known 
+// (file writers do not support this)
+struct WriterPlaceholder writer_reserve(struct Writer *self, usize len);
+// fills in a placeholder with exactly as many bytes as were set aside
+void writer_patch(struct Writer *self, struct WriterPlaceholder placeholder, char const *bytes);
 
-void writer_write(struct Writer const *self, char const *string);
-void writer_writef(struct Writer const *self, char const *format_string, ...) ATTRIBUTE_PRINTF_LIKE(2, 3);
-void writer_write_charslice(struct Writer const *self, struct CharSlice slice);
+// inline so that the length of a string literal is known at compile time
+static inline void writer_write(struct Writer *const self, char const *const string) {
+    writer_write_bytes(self, string, strlen(string));
+}
 
+static inline void writer_write_charslice(struct Writer *const self, struct CharSlice const slice) {
+    writer_write_bytes(self, slice.ptr, slice.len);
+}
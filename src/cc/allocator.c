@@ -0,0 +1,125 @@
+#include "cc/allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/arena.h"
+#include "cc/log.h"
+
+#define POOL_MIN_SIZE_CLASS_LEN 16u
+
+//--------------------------------------------------------------------------------
+// Heap
+//--------------------------------------------------------------------------------
+
+static void *heap_alloc(void *const context, usize const len) {
+    (void) context;
+    return malloc(len);
+}
+
+static void *heap_realloc(void *const context, void *const ptr, usize const old_len, usize const new_len) {
+    (void) context;
+    (void) old_len;
+    return realloc(ptr, new_len);
+}
+
+static void heap_free(void *const context, void *const ptr, usize const len) {
+    (void) context;
+    (void) len;
+    free(ptr);
+}
+
+struct Allocator const heap_allocator = {
+    .alloc = heap_alloc,
+    .realloc = heap_realloc,
+    .free = heap_free,
+    .context = NULL,
+};
+
+//--------------------------------------------------------------------------------
+// Pool
+//--------------------------------------------------------------------------------
+
+// size class of an allocation of `len` bytes, or POOL_SIZE_CLASS_COUNT if it is too large for 
+// any (such allocations come straight from the arena and are not reused)
+static usize pool_size_class(usize const len) {
+    usize size_class = 0u;
+    usize class_len = POOL_MIN_SIZE_CLASS_LEN;
+
+    while (class_len < len && size_class < POOL_SIZE_CLASS_COUNT) {
+        size_class += 1u;
+        class_len *= 2u;
+    }
+
+    return size_class;
+}
+
+static usize pool_size_class_len(usize const size_class) {
+    return (usize) POOL_MIN_SIZE_CLASS_LEN << size_class;
+}
+
+void pool_init(struct Pool *const self, usize const block_len) {
+    arena_init(&self->arena, block_len);
+
+    for (usize size_class = 0u; size_class < POOL_SIZE_CLASS_COUNT; size_class += 1u) {
+        self->free_lists[size_class] = NULL;
+    }
+}
+
+void pool_free(struct Pool *const self) {
+    arena_free(&self->arena);
+}
+
+static void *pool_alloc(void *const context, usize const len) {
+    struct Pool *const self = context;
+    usize const size_class = pool_size_class(len);
+
+    if (size_class == POOL_SIZE_CLASS_COUNT) {
+        return arena_alloc(&self->arena, len);
+    }
+
+    void *const head = self->free_lists[size_class];
+    if (head != NULL) {
+        memcpy(&self->free_lists[size_class], head, sizeof (void *));
+        return head;
+    }
+
+    return arena_alloc(&self->arena, pool_size_class_len(size_class));
+}
+
+static void pool_release(void *const context, void *const ptr, usize const len) {
+    struct Pool *const self = context;
+    usize const size_class = pool_size_class(len);
+
+    if (ptr == NULL || size_class == POOL_SIZE_CLASS_COUNT) {
+        return;
+    }
+
+    memcpy(ptr, &self->free_lists[size_class], sizeof (void *));
+    self->free_lists[size_class] = ptr;
+}
+
+static void *pool_realloc(void *const context, void *const ptr, usize const old_len, usize const new_len) {
+    // still fits the size class it was allocated with
+    if (ptr != NULL && pool_size_class(old_len) == pool_size_class(new_len) 
+        && pool_size_class(new_len) != POOL_SIZE_CLASS_COUNT
+    ) {
+        return ptr;
+    }
+
+    void *const new_ptr = pool_alloc(context, new_len);
+    if (ptr != NULL) {
+        memcpy(new_ptr, ptr, min_usize(old_len, new_len));
+        pool_release(context, ptr, old_len);
+    }
+    return new_ptr;
+}
+
+struct Allocator pool_allocator(struct Pool *const pool) {
+    return (struct Allocator) {
+        .alloc = pool_alloc,
+        .realloc = pool_realloc,
+        .free = pool_release,
+        .context = pool,
+    };
+}
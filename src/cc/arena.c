@@ -2,49 +2,216 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include "cc/log.h"
 
+// Regular blocks grow geometrically up to this many times the size of the first block
+#define ARENA_BLOCK_GROWTH_LIMIT 64u
+
+// Granularity with which pages of a reserved block are committed 
+#define ARENA_COMMIT_LEN (64u * 1024u)
+#define ARENA_HUGE_PAGE_LEN (2u * 1024u * 1024u)
+
 struct ArenaBlock {
-    void *ptr;
+    // Block allocated before this one
+    struct ArenaBlock *prev;
     usize used;
+    // Bytes at the start of `data` that can be used without committing more pages
+    usize committed;
     usize total;
+    char data[];
 };
 
-static void arena_block_init(struct ArenaBlock *const self, usize const len) {
-    self->ptr = malloc(len);
+static struct ArenaBlock *arena_block_new(usize const len) {
+    struct ArenaBlock *const self = malloc(sizeof (struct ArenaBlock) + len);
+    if (self == NULL) {
+        log_error("cannot allocate arena block of %zu bytes", len);
+        exit(1);
+    }
+
+    self->prev = NULL;
     self->used = 0u;
+    self->committed = len;
     self->total = len;
+    return self;
 }
 
-static void arena_block_free(struct ArenaBlock *const self) {
-    free(self->ptr);
+// Frees `block` and every block before it
+static void arena_free_chain(struct Arena *const self, struct ArenaBlock *block) {
+    while (block != NULL) {
+        struct ArenaBlock *const prev = block->prev;
+        if (block == self->reserved) {
+            munmap(self->reservation, self->reservation_len);
+        } else {
+            free(block);
+        }
+        block = prev;
+    }
 }
 
-// If the block can accommodate `len` more bytes, allocates that in the block and returns 
-// the address. Otherwise returns NULL
-static void *arena_block_try_alloc(struct ArenaBlock *const self, usize const len) {
-    if (self->used + len < self->total) {
-        void *address = self->ptr + self->used;
-        self->used += len;
-        return address;
-    } else {
-        return NULL;
+// Ensures the first `len` bytes of the reserved block are committed, returns false if they 
+// are not within the reservation
+static bool arena_commit(struct Arena *const self, struct ArenaBlock *const block, usize const len) {
+    if (block != self->reserved || len > block->total) {
+        return false;
     }
+
+    // pages are committed from the page the block header is on
+    usize const header_len = (usize) (block->data - (char *) block);
+    usize const committed = min_usize(
+        round_up_usize(header_len + len, self->commit_len), 
+        header_len + block->total
+    );
+    if (mprotect(block, committed, PROT_READ | PROT_WRITE) != 0) {
+        log_error("cannot commit %zu bytes of reserved arena", committed);
+        exit(1);
+    }
+
+    block->committed = committed - header_len;
+    return true;
 }
 
-static struct ArenaBlock *arena_add_block(struct Arena *const self) {
-    self->block_count += 1;
-    self->blocks = realloc(self->blocks, self->block_count);
+// Padding needed before the next allocation in the block to align it to `alignment`
+static usize arena_block_padding(struct ArenaBlock const *const self, usize const alignment) {
+    uintptr_t const address = (uintptr_t) (self->data + self->used);
+    return (usize) (-address & (alignment - 1u));
+}
+
+// Makes a new regular block, with room for `len` bytes at `alignment`, the current block
+static struct ArenaBlock *arena_add_block(
+    struct Arena *const self, 
+    usize const len, 
+    usize const alignment
+) {
+    usize block_len = self->block_len;
+    if (self->current != NULL) {
+        block_len = min_usize(self->current->total * 2u, self->block_len * ARENA_BLOCK_GROWTH_LIMIT);
+    }
+    block_len = max_usize(block_len, len + alignment - 1u);
+
+    struct ArenaBlock *new_block;
+    if (self->spare != NULL && self->spare->total >= block_len) {
+        new_block = self->spare;
+        new_block->used = 0u;
+    } else {
+        free(self->spare);
+        new_block = arena_block_new(block_len);
+    }
+    self->spare = NULL;
+
+    new_block->prev = self->current;
+    self->current = new_block;
+    self->bytes_reserved += new_block->total;
+    self->block_count += 1u;
 
-    struct ArenaBlock *const new_block = &self->blocks[self->block_count - 1u];
-    arena_block_init(new_block, self->block_len);
     return new_block;
 }
 
+// Allocations larger than this get a dedicated block, rather than abandoning most of the 
+// current block 
+static bool arena_is_oversized(struct Arena const *const self, usize const len) {
+    return len > self->block_len / 2u;
+}
+
+static void *arena_alloc_oversized(
+    struct Arena *const self, 
+    usize const len, 
+    usize const alignment
+) {
+    struct ArenaBlock *const block = arena_block_new(len + alignment - 1u);
+    block->used = arena_block_padding(block, alignment);
+    void *const address = block->data + block->used;
+    block->used = block->total;
+
+    block->prev = self->oversized;
+    self->oversized = block;
+    self->bytes_reserved += block->total;
+    self->block_count += 1u;
+
+    return address;
+}
+
 void arena_init(struct Arena *const self, usize const block_len) {
-    self->blocks = NULL;
-    self->block_count = 0u;
+    self->current = NULL;
+    self->oversized = NULL;
+    self->spare = NULL;
+    self->reserved = NULL;
+    self->reservation = NULL;
+    self->reservation_len = 0u;
+    self->commit_len = 0u;
     self->block_len = block_len;
+    self->bytes_requested = 0u;
+    self->bytes_reserved = 0u;
+    self->block_count = 0u;
+}
+
+// Makes an arena whose first block spans `reserve_len` bytes of address space, committed as 
+// it is used. Blocks of `block_len` bytes and up are only added if the reservation runs out
+// With `use_huge_pages`, the range is aligned for and advised to use transparent huge pages 
+// Returns false if the range cannot be reserved
+bool arena_init_reserved(
+    struct Arena *const self, 
+    usize const block_len, 
+    usize const reserve_len, 
+    bool const use_huge_pages
+) {
+    usize const page_len = (usize) sysconf(_SC_PAGESIZE);
+    usize const commit_len = use_huge_pages 
+        ? ARENA_HUGE_PAGE_LEN 
+        : max_usize(ARENA_COMMIT_LEN, page_len);
+    usize const aligned_len = round_up_usize(reserve_len, commit_len);
+
+    // huge pages need a 2 MiB aligned range, so reserve enough to align the start
+    usize const reservation_len = aligned_len + (use_huge_pages ? commit_len : 0u);
+    void *const reservation = mmap(
+        NULL,
+        reservation_len,
+        PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+        -1,
+        0
+    );
+    if (reservation == MAP_FAILED) {
+        return false;
+    }
+
+    uintptr_t const start = use_huge_pages 
+        ? round_up_usize((uintptr_t) reservation, commit_len) 
+        : (uintptr_t) reservation;
+    struct ArenaBlock *const block = (struct ArenaBlock *) start;
+
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages) {
+        // advisory only
+        madvise(block, aligned_len, MADV_HUGEPAGE);
+    }
+#endif
+
+    arena_init(self, block_len);
+    self->reserved = block;
+    self->reservation = reservation;
+    self->reservation_len = reservation_len;
+    self->commit_len = commit_len;
+
+    // commit the page holding the block header
+    if (mprotect(block, commit_len, PROT_READ | PROT_WRITE) != 0) {
+        munmap(reservation, reservation_len);
+        return false;
+    }
+
+    block->prev = NULL;
+    block->used = 0u;
+    block->total = aligned_len - sizeof (struct ArenaBlock);
+    block->committed = commit_len - sizeof (struct ArenaBlock);
+
+    // the reserved block counts towards `bytes_reserved` as it is committed, see 
+    // `arena_statistics`
+    self->current = block;
+    self->block_count = 1u;
+
+    return true;
 }
 
 void arena_free(struct Arena *const self) {
@@ -52,23 +219,35 @@ void arena_free(struct Arena *const self) {
 }
 
 void *arena_alloc(struct Arena *const self, usize const len) {
-    if (len > self->block_len) {
-        log_error("cannot allocate %zu bytes in arena: len > block_len", len);
+    return arena_alloc_aligned(self, len, ARENA_DEFAULT_ALIGNMENT);
+}
+
+// `alignment` must be a power of two
+void *arena_alloc_aligned(struct Arena *const self, usize const len, usize const alignment) {
+    if (alignment == 0u || (alignment & (alignment - 1u)) != 0u) {
+        log_error("arena_alloc_aligned: alignment %zu is not a power of two", alignment);
         exit(1);
     }
 
-    for (usize i = 0u; i < self->block_count; i += 1) {
-        struct ArenaBlock *const block = &self->blocks[i];
-        void *address = arena_block_try_alloc(block, len);
+    self->bytes_requested += len;
+
+    if (arena_is_oversized(self, len)) {
+        return arena_alloc_oversized(self, len, alignment);
+    }
 
-        if (address != NULL) {
-            return address;
+    struct ArenaBlock *block = self->current;
+    usize padding = (block == NULL) ? 0u : arena_block_padding(block, alignment);
+
+    if (UNLIKELY(block == NULL || padding + len > block->committed - block->used)) {
+        if (block == NULL || !arena_commit(self, block, block->used + padding + len)) {
+            block = arena_add_block(self, len, alignment);
+            padding = arena_block_padding(block, alignment);
         }
     }
 
-    // Arena full
-    struct ArenaBlock *const new_block = arena_add_block(self);
-    return arena_block_try_alloc(new_block, len);
+    void *const address = block->data + block->used + padding;
+    block->used += padding + len;
+    return address;
 }
 
 void *arena_copy(struct Arena *self, void const *item, usize item_size) {
@@ -77,13 +256,93 @@ void *arena_copy(struct Arena *self, void const *item, usize item_size) {
     return ptr;
 }
 
+// Extends the allocation of `len` bytes at `ptr` to `new_len` bytes without moving it, which 
+// is possible when it is the last allocation in the current block and the block has room
+// Returns false if it is not
+bool arena_try_extend(struct Arena *const self, void *const ptr, usize const len, usize const new_len) {
+    struct ArenaBlock *const block = self->current;
+
+    if (block == NULL || (char *) ptr + len != block->data + block->used) {
+        return false;
+    }
+
+    usize const extra_len = new_len - len;
+    if (extra_len > block->committed - block->used 
+        && !arena_commit(self, block, block->used + extra_len)) {
+        return false;
+    }
+
+    block->used += extra_len;
+    self->bytes_requested += extra_len;
+    return true;
+}
+
+// Releases every block, including the reserved range of an arena made with 
+// `arena_init_reserved`, which then carries on as a regular arena
 void arena_clear(struct Arena *const self) {
-    for (usize i = 0u; i < self->block_count; i += 1) {
-        arena_block_free(&self->blocks[i]);
+    arena_free_chain(self, self->current);
+    arena_free_chain(self, self->oversized);
+    free(self->spare);
+
+    arena_init(self, self->block_len);
+}
+
+struct ArenaMark arena_mark(struct Arena const *const self) {
+    return (struct ArenaMark) {
+        .current = self->current,
+        .used = (self->current == NULL) ? 0u : self->current->used,
+        .oversized = self->oversized,
+        .bytes_requested = self->bytes_requested,
+    };
+}
+
+// Releases everything allocated since `mark` was taken
+void arena_reset_to_mark(struct Arena *const self, struct ArenaMark const mark) {
+    while (self->current != mark.current) {
+        struct ArenaBlock *const block = self->current;
+        self->current = block->prev;
+        self->bytes_reserved -= block->total;
+        self->block_count -= 1u;
+
+        // keep one block around, so that backtracking across a block boundary does not 
+        // allocate and free a block every time
+        if (self->spare == NULL || self->spare->total < block->total) {
+            free(self->spare);
+            self->spare = block;
+        } else {
+            free(block);
+        }
     }
 
-    free(self->blocks);
-    self->blocks = NULL;
+    if (self->current != NULL) {
+        self->current->used = mark.used;
+    }
+
+    while (self->oversized != mark.oversized) {
+        struct ArenaBlock *const block = self->oversized;
+        self->oversized = block->prev;
+        self->bytes_reserved -= block->total;
+        self->block_count -= 1u;
+        free(block);
+    }
+
+    self->bytes_requested = mark.bytes_requested;
+}
+
+struct ArenaStatistics arena_statistics(struct Arena const *const self) {
+    usize const bytes_free = (self->current == NULL) 
+        ? 0u 
+        : self->current->committed - self->current->used;
+    usize const bytes_reserved = (self->reserved == NULL) 
+        ? self->bytes_reserved 
+        : self->bytes_reserved + self->reserved->committed;
+
+    return (struct ArenaStatistics) {
+        .bytes_requested = self->bytes_requested,
+        .bytes_wasted = bytes_reserved - self->bytes_requested - bytes_free,
+        .bytes_reserved = bytes_reserved,
+        .block_count = self->block_count,
+    };
 }
 
 void arenavec_init(
@@ -115,11 +374,26 @@ void arenavec_push(
     void *const item
 ) {
     if (self->len + 1 > self->cap) {
-        self->cap = (self->cap == 0u) 
+        usize const new_cap = (self->cap == 0u) 
             ? 16u // hardcoded initial capacity
             : self->cap * 2;
 
-        self->data = arena_alloc(self->backing_arena, self->element_size * self->cap);
+        // grow in place if nothing has been allocated after the data, otherwise move it
+        bool const is_extended = self->data != NULL && arena_try_extend(
+            self->backing_arena, 
+            self->data, 
+            self->element_size * self->cap, 
+            self->element_size * new_cap
+        );
+        if (!is_extended) {
+            void *const new_data = arena_alloc(self->backing_arena, self->element_size * new_cap);
+            if (self->len != 0u) {
+                memcpy(new_data, self->data, self->element_size * self->len);
+            }
+            self->data = new_data;
+        }
+
+        self->cap = new_cap;
     }
 
     memcpy(self->data + self->len * self->element_size, item, self->element_size);
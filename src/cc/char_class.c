@@ -0,0 +1,224 @@
+#include "cc/char_class.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #define CHAR_CLASS_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+u8 char_class_table[256];
+
+static struct {
+    bool initialized;
+    usize (*scan_whitespace)(char const *ptr);
+    usize (*scan_word)(char const *ptr);
+} kernels;
+
+#ifndef CHAR_CLASS_X86_KERNELS
+
+// ----------------------------
+//   scalar (table) kernels
+// ----------------------------
+
+static usize scan_whitespace_scalar(char const *const ptr) {
+    usize len = 0u;
+
+    while (char_has_class(ptr[len], CharClassWhitespace)) {
+        len += 1u;
+    }
+
+    return len;
+}
+
+static usize scan_word_scalar(char const *const ptr) {
+    usize len = 0u;
+
+    while (char_has_class(ptr[len], CharClassLetter | CharClassDigit)) {
+        len += 1u;
+    }
+
+    return len;
+}
+
+#else
+
+
+// The vector kernels only use aligned loads, so they never cross into a page that does not 
+// contain part of the string. Bytes of the first block that come before `ptr` are masked out
+
+// ----------------
+//   SSE2 kernels
+// ----------------
+
+// mask of bytes in `v` that are in [lo, hi]
+static inline __m128i sse2_in_range(__m128i const v, char const lo, char const hi) {
+    __m128i const offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    __m128i const excess = _mm_subs_epu8(offset, _mm_set1_epi8((char) (hi - lo)));
+    return _mm_cmpeq_epi8(excess, _mm_setzero_si128());
+}
+
+static usize scan_whitespace_sse2(char const *const ptr) {
+    usize const misalignment = (uintptr_t) ptr & 15u;
+    char const *block = ptr - misalignment;
+    u32 valid = (0xffffu << misalignment) & 0xffffu;
+
+    for (;;) {
+        __m128i const v = _mm_load_si128((__m128i const *) block);
+        __m128i const whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')))
+        );
+
+        u32 const other = ~(u32) _mm_movemask_epi8(whitespace) & valid;
+
+        if (other != 0u) {
+            return (usize) (block - ptr) + (usize) __builtin_ctz(other);
+        }
+
+        block += 16;
+        valid = 0xffffu;
+    }
+}
+
+static usize scan_word_sse2(char const *const ptr) {
+    usize const misalignment = (uintptr_t) ptr & 15u;
+    char const *block = ptr - misalignment;
+    u32 valid = (0xffffu << misalignment) & 0xffffu;
+
+    for (;;) {
+        __m128i const v = _mm_load_si128((__m128i const *) block);
+        __m128i const word = _mm_or_si128(
+            _mm_or_si128(
+                sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+                sse2_in_range(v, '0', '9')
+            ),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))
+        );
+
+        u32 const other = ~(u32) _mm_movemask_epi8(word) & valid;
+
+        if (other != 0u) {
+            return (usize) (block - ptr) + (usize) __builtin_ctz(other);
+        }
+
+        block += 16;
+        valid = 0xffffu;
+    }
+}
+
+// ----------------
+//   AVX2 kernels
+// ----------------
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_in_range(__m256i const v, char const lo, char const hi) {
+    __m256i const offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    __m256i const excess = _mm256_subs_epu8(offset, _mm256_set1_epi8((char) (hi - lo)));
+    return _mm256_cmpeq_epi8(excess, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static usize scan_whitespace_avx2(char const *const ptr) {
+    usize const misalignment = (uintptr_t) ptr & 31u;
+    char const *block = ptr - misalignment;
+    u32 valid = 0xffffffffu << misalignment;
+
+    for (;;) {
+        __m256i const v = _mm256_load_si256((__m256i const *) block);
+        __m256i const whitespace = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), 
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), 
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))
+            )
+        );
+
+        u32 const other = ~(u32) _mm256_movemask_epi8(whitespace) & valid;
+
+        if (other != 0u) {
+            return (usize) (block - ptr) + (usize) __builtin_ctz(other);
+        }
+
+        block += 32;
+        valid = 0xffffffffu;
+    }
+}
+
+__attribute__((target("avx2")))
+static usize scan_word_avx2(char const *const ptr) {
+    usize const misalignment = (uintptr_t) ptr & 31u;
+    char const *block = ptr - misalignment;
+    u32 valid = 0xffffffffu << misalignment;
+
+    for (;;) {
+        __m256i const v = _mm256_load_si256((__m256i const *) block);
+        __m256i const word = _mm256_or_si256(
+            _mm256_or_si256(
+                avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'),
+                avx2_in_range(v, '0', '9')
+            ),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'))
+        );
+
+        u32 const other = ~(u32) _mm256_movemask_epi8(word) & valid;
+
+        if (other != 0u) {
+            return (usize) (block - ptr) + (usize) __builtin_ctz(other);
+        }
+
+        block += 32;
+        valid = 0xffffffffu;
+    }
+}
+
+#endif // CHAR_CLASS_X86_KERNELS
+
+void char_class_init(void) {
+    if (kernels.initialized) {
+        return;
+    }
+
+    for (usize c = 0u; c < 256u; c += 1u) {
+        u8 char_class = 0u;
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            char_class |= CharClassWhitespace;
+        }
+        if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_') {
+            char_class |= CharClassLetter;
+        }
+        if ('0' <= c && c <= '9') {
+            char_class |= CharClassDigit;
+        }
+
+        char_class_table[c] = char_class;
+    }
+
+#ifdef CHAR_CLASS_X86_KERNELS
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.scan_whitespace = scan_whitespace_avx2;
+        kernels.scan_word = scan_word_avx2;
+    } else {
+        // SSE2 is part of x86-64
+        kernels.scan_whitespace = scan_whitespace_sse2;
+        kernels.scan_word = scan_word_sse2;
+    }
+#else
+    kernels.scan_whitespace = scan_whitespace_scalar;
+    kernels.scan_word = scan_word_scalar;
+#endif
+
+    kernels.initialized = true;
+}
+
+usize scan_whitespace(char const *const ptr) {
+    return kernels.scan_whitespace(ptr);
+}
+
+usize scan_word(char const *const ptr) {
+    return kernels.scan_word(ptr);
+}
@@ -0,0 +1,217 @@
+#include "cc/chunk_list.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "cc/log.h"
+
+// full chunks are written out once this many have piled up
+#define CHUNK_LIST_FLUSH_COUNT 16u
+// chunks passed to one writev call (well below IOV_MAX on every system we target)
+#define CHUNK_LIST_IOV_LEN 64u
+
+void chunk_list_init(struct ChunkList *const self, i32 const fd) {
+    *self = (struct ChunkList) {
+        .first = NULL,
+        .last = NULL,
+        .chunk_count = 0u,
+        .fd = fd,
+        .spare = NULL,
+        .placeholder_count = 0u,
+        .pinned = NULL,
+    };
+}
+
+static void chunk_list_free_chain(struct Chunk *chunk) {
+    while (chunk != NULL) {
+        struct Chunk *const next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void chunk_list_free(struct ChunkList *const self) {
+    chunk_list_free_chain(self->first);
+    chunk_list_free_chain(self->spare);
+
+    self->first = NULL;
+    self->last = NULL;
+    self->chunk_count = 0u;
+    self->spare = NULL;
+    self->placeholder_count = 0u;
+    self->pinned = NULL;
+}
+
+static struct Chunk *chunk_list_new_chunk(struct ChunkList *const self) {
+    struct Chunk *chunk = self->spare;
+
+    if (chunk != NULL) {
+        self->spare = chunk->next;
+    } else {
+        chunk = malloc(sizeof (struct Chunk));
+        if (chunk == NULL) {
+            log_error("chunk_list: cannot allocate chunk");
+            exit(1);
+        }
+    }
+
+    chunk->next = NULL;
+    chunk->len = 0u;
+    return chunk;
+}
+
+// writes the chunks before `end` to the file with writev, and keeps them as spares
+static void chunk_list_write_until(struct ChunkList *const self, struct Chunk *const end) {
+    if (self->fd < 0) {
+        log_error("chunk_list: no file to write to");
+        exit(1);
+    }
+
+    while (self->first != end) {
+        struct iovec iov[CHUNK_LIST_IOV_LEN];
+        usize iov_len = 0u;
+
+        for (
+            struct Chunk *chunk = self->first; 
+            chunk != end && iov_len < CHUNK_LIST_IOV_LEN; 
+            chunk = chunk->next
+        ) {
+            iov[iov_len] = (struct iovec) { .iov_base = chunk->data, .iov_len = chunk->len };
+            iov_len += 1u;
+        }
+
+        // writev may write less than asked for, carry on from where it stopped
+        usize iov_start = 0u;
+        while (iov_start < iov_len) {
+            ssize_t const written = writev(self->fd, iov + iov_start, (i32) (iov_len - iov_start));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                log_error("chunk_list: write failed: %s", strerror(errno));
+                exit(1);
+            }
+
+            usize remaining = (usize) written;
+            while (iov_start < iov_len && remaining >= iov[iov_start].iov_len) {
+                remaining -= iov[iov_start].iov_len;
+                iov_start += 1u;
+            }
+            if (iov_start < iov_len) {
+                iov[iov_start].iov_base = (char *) iov[iov_start].iov_base + remaining;
+                iov[iov_start].iov_len -= remaining;
+            }
+        }
+
+        for (usize i = 0u; i < iov_len; i += 1u) {
+            struct Chunk *const chunk = self->first;
+            self->first = chunk->next;
+            self->chunk_count -= 1u;
+
+            chunk->next = self->spare;
+            self->spare = chunk;
+        }
+    }
+
+    if (self->first == NULL) {
+        self->last = NULL;
+    }
+}
+
+char *chunk_list_space(struct ChunkList *const self, usize const min_len, usize *const available_out) {
+    if (min_len > CHUNK_LEN) {
+        return NULL;
+    }
+
+    if (self->last == NULL || CHUNK_LEN - self->last->len < min_len) {
+        // stream out the full chunks before starting another one, but none that is still 
+        // waiting for a placeholder to be patched
+        if (self->fd >= 0 && self->chunk_count >= CHUNK_LIST_FLUSH_COUNT) {
+            chunk_list_write_until(self, self->pinned);
+        }
+
+        struct Chunk *const chunk = chunk_list_new_chunk(self);
+        if (self->last == NULL) {
+            self->first = chunk;
+        } else {
+            self->last->next = chunk;
+        }
+        self->last = chunk;
+        self->chunk_count += 1u;
+    }
+
+    *available_out = CHUNK_LEN - self->last->len;
+    return self->last->data + self->last->len;
+}
+
+void chunk_list_advance(struct ChunkList *const self, usize const len) {
+    self->last->len += len;
+}
+
+struct ChunkPlaceholder chunk_list_reserve(struct ChunkList *const self, usize const len) {
+    usize available;
+    if (chunk_list_space(self, len, &available) == NULL) {
+        log_error("chunk_list_reserve: %zu bytes do not fit in a chunk", len);
+        exit(1);
+    }
+
+    struct ChunkPlaceholder const placeholder = {
+        .chunk = self->last,
+        .offset = self->last->len,
+        .len = len,
+    };
+    chunk_list_advance(self, len);
+
+    if (self->placeholder_count == 0u) {
+        self->pinned = placeholder.chunk;
+    }
+    self->placeholder_count += 1u;
+
+    return placeholder;
+}
+
+void chunk_list_patch(
+    struct ChunkList *const self, 
+    struct ChunkPlaceholder const placeholder, 
+    char const *const bytes
+) {
+    if (self->placeholder_count == 0u) {
+        log_error("chunk_list_patch: no placeholder to patch");
+        exit(1);
+    }
+
+    memcpy(placeholder.chunk->data + placeholder.offset, bytes, placeholder.len);
+
+    // the chunks stay pinned until the last placeholder is patched, placeholders are short-lived
+    self->placeholder_count -= 1u;
+    if (self->placeholder_count == 0u) {
+        self->pinned = NULL;
+    }
+}
+
+void chunk_list_append(struct ChunkList *const self, struct ChunkList *const other) {
+    if (other->first != NULL) {
+        if (self->last == NULL) {
+            self->first = other->first;
+        } else {
+            self->last->next = other->first;
+        }
+        self->last = other->last;
+        self->chunk_count += other->chunk_count;
+    }
+
+    other->first = NULL;
+    other->last = NULL;
+    other->chunk_count = 0u;
+}
+
+void chunk_list_flush(struct ChunkList *const self) {
+    if (self->placeholder_count != 0u) {
+        log_error("chunk_list_flush: %zu placeholder(s) not patched", self->placeholder_count);
+        exit(1);
+    }
+
+    chunk_list_write_until(self, NULL);
+}
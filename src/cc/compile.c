@@ -1,44 +1,84 @@
 #include "cc/compile.h"
 
+#include "cc/allocator.h"
+#include "cc/chunk_list.h"
+#include "cc/compile/assembly.h"
 #include "cc/compile/compiler.h"
+#include "cc/compile/encoder.h"
 #include "cc/compile/function_table.h"
 #include "cc/compile/root.h"
 #include "cc/compile/variable_table.h"
 #include "cc/writer.h"
 
-struct CompileResult compile(struct Writer *assembly_writer, struct AstRoot *const ast) {
-    struct CharVec section_text, section_data;
-    charvec_init(&section_text);
-    charvec_init(&section_data);
+#define COMPILE_POOL_BLOCK_LEN (1024u * 1024u)
 
-    struct Writer writer_text = charvec_writer(&section_text);
-    struct Writer writer_data = charvec_writer(&section_data);
+// compiles `ast` into the given sections
+static struct CompileResult compile_sections(
+    struct Emitter const emitter_text, 
+    struct Emitter const emitter_data, 
+    struct AstRoot *const ast
+) {
+    // the tables only live until the sections are written, so they all come from one pool, 
+    // released in one go
+    struct Pool pool;
+    pool_init(&pool, COMPILE_POOL_BLOCK_LEN);
+    struct Allocator const allocator = pool_allocator(&pool);
 
-    struct VariableTable global_variable_table;
-    variable_table_init(&global_variable_table, NULL);
+    struct VariableTable variable_table;
+    variable_table_init(&variable_table, &allocator);
 
     struct FunctionTable function_table;
-    function_table_init(&function_table);
+    function_table_init(&function_table, &allocator);
 
     struct Compiler compiler = {
-        .writer_text = writer_text,
-        .writer_data = writer_data,
-        .variable_table = &global_variable_table,
+        .emitter_text = emitter_text,
+        .emitter_data = emitter_data,
+        .variable_table = &variable_table,
         .function_table = &function_table,
     };
-    struct CompileResult result = compile_root(&compiler, ast);
+    struct CompileResult const result = compile_root(&compiler, ast);
 
-    // write assembly
-    writer_write(assembly_writer, "global main\n");
-    writer_write(assembly_writer, "section .data\n");
-    writer_write_charslice(assembly_writer, charvec_slice_whole(&section_data));
-    writer_write(assembly_writer, "section .text\n");
-    writer_write_charslice(assembly_writer, charvec_slice_whole(&section_text));
-
-    variable_table_free(&global_variable_table);
+    // function signatures are allocated on the heap
     function_table_free(&function_table);
-    charvec_free(&section_text);
-    charvec_free(&section_data);
+    pool_free(&pool);
+
+    return result;
+}
+
+struct CompileResult compile(struct ChunkList *const assembly, struct AstRoot *const ast) {
+    // the text section goes straight into the output, the data section is held back and 
+    // appended after it
+    struct ChunkList section_data;
+    chunk_list_init(&section_data, -1);
+
+    struct Writer writer_text = chunk_list_writer(assembly);
+    struct Writer writer_data = chunk_list_writer(&section_data);
+
+    writer_write(&writer_text, "global main\n");
+    writer_write(&writer_text, "section .text\n");
+
+    struct CompileResult const result = compile_sections(
+        text_emitter(&writer_text), 
+        text_emitter(&writer_data), 
+        ast
+    );
+
+    writer_write(&writer_text, "section .data\n");
+    chunk_list_append(assembly, &section_data);
+    chunk_list_free(&section_data);
+
+    return result;
+}
+
+struct CompileResult compile_code(
+    struct CodeBuffer *const text, 
+    struct CodeBuffer *const data, 
+    struct AstRoot *const ast
+) {
+    struct CompileResult const result = compile_sections(code_emitter(text), code_emitter(data), ast);
+
+    code_buffer_resolve_fixups(text);
+    code_buffer_resolve_fixups(data);
 
     return result;
 }
@@ -1,8 +1,11 @@
 #include "cc/compile/assembly.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cc/common.h"
+#include "cc/compile/encoder.h"
 #include "cc/integer_size.h"
 #include "cc/log.h"
 #include "cc/type.h"
@@ -59,7 +62,7 @@ char const *format_operand_width(
         exit(1);
     }
 
-    char const *const names[4] = {
+    static char const *const names[4] = {
         "byte",
         "word",
         "dword",
@@ -82,7 +85,7 @@ char const *format_register(
         exit(1);
     }
 
-    char const *const byte_names[RegisterCount] = {
+    static char const *const byte_names[RegisterCount] = {
         "al",
         "bl",
         "cl",
@@ -101,7 +104,7 @@ char const *format_register(
         "r15b"
     };
 
-    char const *const word_names[RegisterCount] = {
+    static char const *const word_names[RegisterCount] = {
         "ax",
         "bx",
         "cx",
@@ -110,8 +113,8 @@ char const *format_register(
         "di",
         "sp",
         "bp",
-        "r8d",
-        "r9d",
+        "r8w",
+        "r9w",
         "r10w",
         "r11w",
         "r12w",
@@ -120,7 +123,7 @@ char const *format_register(
         "r15w"
     };
 
-    char const *const dword_names[RegisterCount] = {
+    static char const *const dword_names[RegisterCount] = {
         "eax",
         "ebx",
         "ecx",
@@ -139,7 +142,7 @@ char const *format_register(
         "r15d"
     };
 
-    char const *const qword_names[RegisterCount] = {
+    static char const *const qword_names[RegisterCount] = {
         "rax",
         "rbx",
         "rcx",
@@ -178,7 +181,7 @@ char const *format_instruction(enum Instruction instruction) {
         exit(1);
     }
 
-    char const *const names[InstructionCount] = {
+    static char const *const names[InstructionCount] = {
         "leave",
         "ret",
         "cdq",
@@ -204,7 +207,7 @@ usize instruction_expected_operand_count(enum Instruction instruction) {
         exit(1);
     }
 
-    usize counts[InstructionCount] = {
+    static usize const counts[InstructionCount] = {
         0u,
         0u,
         0u,
@@ -308,6 +311,28 @@ struct Operand operand_displace(struct Operand operand, i64 const amount_bytes)
     }
 }
 
+struct Emitter text_emitter(struct Writer *const writer) {
+    return (struct Emitter) {
+        .kind = EmitterText,
+        .variant.text = writer,
+    };
+}
+
+struct Emitter code_emitter(struct CodeBuffer *const code) {
+    return (struct Emitter) {
+        .kind = EmitterCode,
+        .variant.code = code,
+    };
+}
+
+// writes a displacement as "%+ld" would
+static void emit_displacement(struct Writer *const assembly_writer, i64 const displacement) {
+    if (displacement >= 0) {
+        writer_write_char(assembly_writer, '+');
+    }
+    writer_write_i64(assembly_writer, displacement);
+}
+
 void emit_operand(
     struct Writer *const assembly_writer, 
     struct Operand const operand, 
@@ -315,11 +340,7 @@ void emit_operand(
 ) {
     switch (operand.kind) {
         case OperandImmediate: {
-            writer_writef(
-                assembly_writer,
-                "%lu",
-                operand.variant.immediate.value
-            );
+            writer_write_u64(assembly_writer, operand.variant.immediate.value);
             break;
         }
         case OperandLabel: {
@@ -337,32 +358,32 @@ void emit_operand(
             break;
         }
         case OperandMemory: {
-            writer_writef(
-                assembly_writer,
-                "%s [%s%+ld]",
-                format_operand_width(width),
-                format_register(operand.variant.memory.base_reg, QWord),
-                operand.variant.memory.displacement
-            );
+            // width [base+displacement]
+            writer_write(assembly_writer, format_operand_width(width));
+            writer_write(assembly_writer, " [");
+            writer_write(assembly_writer, format_register(operand.variant.memory.base_reg, QWord));
+            emit_displacement(assembly_writer, operand.variant.memory.displacement);
+            writer_write_char(assembly_writer, ']');
             break;
         }
         case OperandMemoryIndexed: {
-            writer_writef(
-                assembly_writer,
-                "%s [%s+%s*%ld%+ld]",
-                format_operand_width(width),
-                format_register(operand.variant.memory_indexed.base_reg, QWord),
-                format_register(operand.variant.memory_indexed.index_reg, QWord),
-                operand.variant.memory_indexed.index_scale,
-                operand.variant.memory_indexed.displacement
-            );
+            // width [base+index*scale+displacement]
+            writer_write(assembly_writer, format_operand_width(width));
+            writer_write(assembly_writer, " [");
+            writer_write(assembly_writer, format_register(operand.variant.memory_indexed.base_reg, QWord));
+            writer_write_char(assembly_writer, '+');
+            writer_write(assembly_writer, format_register(operand.variant.memory_indexed.index_reg, QWord));
+            writer_write_char(assembly_writer, '*');
+            writer_write_i64(assembly_writer, operand.variant.memory_indexed.index_scale);
+            emit_displacement(assembly_writer, operand.variant.memory_indexed.displacement);
+            writer_write_char(assembly_writer, ']');
             break;
         }
     }
 }
 
 void emit_instruction(
-    struct Writer *const assembly_writer, 
+    struct Emitter *const emitter, 
     enum Instruction const instruction
 ) {
     if (instruction_expected_operand_count(instruction) != 0) {
@@ -374,13 +395,24 @@ void emit_instruction(
         exit(1);
     }
 
-    writer_write(assembly_writer, "\t");
-    writer_write(assembly_writer, format_instruction(instruction));
-    writer_write(assembly_writer, "\n");
+    switch (emitter->kind) {
+        case EmitterText: {
+            struct Writer *const assembly_writer = emitter->variant.text;
+
+            writer_write(assembly_writer, "\t");
+            writer_write(assembly_writer, format_instruction(instruction));
+            writer_write(assembly_writer, "\n");
+            break;
+        }
+        case EmitterCode: {
+            encode_instruction(emitter->variant.code, instruction);
+            break;
+        }
+    }
 }
 
 void emit_instruction_single_operand(
-    struct Writer *const assembly_writer, 
+    struct Emitter *const emitter, 
     enum Instruction const instruction, 
     enum OperandWidth const operand_width,
     struct Operand const operand
@@ -394,15 +426,26 @@ void emit_instruction_single_operand(
         exit(1);
     }
 
-    writer_write(assembly_writer, "\t");
-    writer_write(assembly_writer, format_instruction(instruction));
-    writer_write(assembly_writer, " ");
-    emit_operand(assembly_writer, operand, operand_width);
-    writer_write(assembly_writer, "\n");
+    switch (emitter->kind) {
+        case EmitterText: {
+            struct Writer *const assembly_writer = emitter->variant.text;
+
+            writer_write(assembly_writer, "\t");
+            writer_write(assembly_writer, format_instruction(instruction));
+            writer_write(assembly_writer, " ");
+            emit_operand(assembly_writer, operand, operand_width);
+            writer_write(assembly_writer, "\n");
+            break;
+        }
+        case EmitterCode: {
+            encode_instruction_single_operand(emitter->variant.code, instruction, operand_width, &operand);
+            break;
+        }
+    }
 }
 
 void emit_instruction_dst_src(
-    struct Writer *const assembly_writer, 
+    struct Emitter *const emitter, 
     enum Instruction const instruction, 
     enum OperandWidth const dst_width,
     enum OperandWidth const src_width,
@@ -418,54 +461,134 @@ void emit_instruction_dst_src(
         exit(1);
     }
 
-    writer_write(assembly_writer, "\t");
-    writer_write(assembly_writer, format_instruction(instruction));
-    writer_write(assembly_writer, " ");
-    emit_operand(assembly_writer, dst, dst_width);
-    writer_write(assembly_writer, ", ");
-    emit_operand(assembly_writer, src, src_width);
-    writer_write(assembly_writer, "\n");
+    switch (emitter->kind) {
+        case EmitterText: {
+            struct Writer *const assembly_writer = emitter->variant.text;
+
+            writer_write(assembly_writer, "\t");
+            writer_write(assembly_writer, format_instruction(instruction));
+            writer_write(assembly_writer, " ");
+            emit_operand(assembly_writer, dst, dst_width);
+            writer_write(assembly_writer, ", ");
+            emit_operand(assembly_writer, src, src_width);
+            writer_write(assembly_writer, "\n");
+            break;
+        }
+        case EmitterCode: {
+            encode_instruction_dst_src(
+                emitter->variant.code, 
+                instruction, 
+                dst_width, 
+                src_width, 
+                &dst, 
+                &src
+            );
+            break;
+        }
+    }
 }
 
-void emit_label(struct Writer *const assembly_writer, struct CharSlice const label) {
-    writer_write_charslice(assembly_writer, label);
-    writer_write(assembly_writer, ":\n");
+void emit_label(struct Emitter *const emitter, struct CharSlice const label) {
+    switch (emitter->kind) {
+        case EmitterText: {
+            writer_write_charslice(emitter->variant.text, label);
+            writer_write(emitter->variant.text, ":\n");
+            break;
+        }
+        case EmitterCode: {
+            code_buffer_define_label(emitter->variant.code, label);
+            break;
+        }
+    }
 }
 
-void emit_function_prologue(struct Writer *const assembly_writer, usize const stack_usage) {
+// "\tsub rsp, " followed by 10 digits (the immediate is a signed dword) and a newline
+#define FUNCTION_PROLOGUE_STACK_ADJUSTMENT_LEN 21u
+
+struct EmitterPlaceholder emit_function_prologue(struct Emitter *const emitter) {
     emit_instruction_single_operand(
-        assembly_writer, 
+        emitter, 
         InstructionPush, 
         QWord,
         operand_register(RegisterBP)
     );
     emit_instruction_dst_src(
-        assembly_writer, 
+        emitter, 
         InstructionMov, 
         QWord,
         QWord,
         operand_register(RegisterBP),
         operand_register(RegisterSP)
     );
-    if (stack_usage > 0u) {
-        emit_instruction_dst_src(
-            assembly_writer, 
-            InstructionSub, 
-            QWord,
-            QWord, 
-            operand_register(RegisterSP),
-            operand_immediate(round_up_usize(stack_usage, 16u))
-        );
+
+    switch (emitter->kind) {
+        case EmitterText: {
+            return (struct EmitterPlaceholder) {
+                .kind = EmitterText,
+                .variant.text = writer_reserve(emitter->variant.text, FUNCTION_PROLOGUE_STACK_ADJUSTMENT_LEN),
+            };
+        }
+        case EmitterCode: {
+            return (struct EmitterPlaceholder) {
+                .kind = EmitterCode,
+                .variant.code = code_buffer_reserve(emitter->variant.code, ENCODED_STACK_ADJUSTMENT_LEN),
+            };
+        }
     }
+
+    log_error("emit_function_prologue: unknown emitter kind %zu", (usize) emitter->kind);
+    exit(1);
 }
 
-void emit_function_exit(struct Writer *assembly_writer) {
-    emit_instruction(assembly_writer, InstructionLeave);
-    emit_instruction(assembly_writer, InstructionRet);
+// fills the placeholder with "sub rsp, N", the immediate padded with leading zeros to the width 
+// of the slot (N is 0 if the function does not use the stack), or for machine code with the 
+// fixed-length encoding of the same instruction (a nop of that length if N is 0)
+void patch_function_prologue(
+    struct Emitter *const emitter, 
+    struct EmitterPlaceholder const placeholder, 
+    usize const stack_usage
+) {
+    usize const frame_size = round_up_usize(stack_usage, 16u);
+    if (frame_size > (usize) INT32_MAX) {
+        log_error("patch_function_prologue: stack frame of %zu bytes is too large", frame_size);
+        exit(1);
+    }
+
+    if (emitter->kind == EmitterCode) {
+        char code[ENCODED_STACK_ADJUSTMENT_LEN];
+        encode_stack_adjustment(code, frame_size);
+        code_buffer_patch(emitter->variant.code, placeholder.variant.code, code, sizeof (code));
+        return;
+    }
+
+    // (and the null terminator)
+    char line[FUNCTION_PROLOGUE_STACK_ADJUSTMENT_LEN + 1u];
+
+    // nasm still reads the zero-padded immediate as decimal
+    i32 const len = snprintf(
+        line, 
+        sizeof (line), 
+        "\t%s %s, %010zu\n", 
+        format_instruction(InstructionSub), 
+        format_register(RegisterSP, QWord), 
+        frame_size
+    );
+
+    if (len != (i32) FUNCTION_PROLOGUE_STACK_ADJUSTMENT_LEN) {
+        log_error("patch_function_prologue: stack adjustment does not fill its slot (%d bytes)", len);
+        exit(1);
+    }
+
+    writer_patch(emitter->variant.text, placeholder.variant.text, line);
+}
+
+void emit_function_exit(struct Emitter *const emitter) {
+    emit_instruction(emitter, InstructionLeave);
+    emit_instruction(emitter, InstructionRet);
 }
 
 void emit_move(
-    struct Writer *const assembly_writer, 
+    struct Emitter *const emitter, 
     struct Operand const dst, 
     struct Operand const src,
     enum OperandWidth const dst_operand_width,
@@ -484,7 +607,7 @@ void emit_move(
     ) {
         // src -> dst
         emit_instruction_dst_src(
-            assembly_writer,
+            emitter,
             InstructionMov,
             dst_operand_width,
             dst_operand_width,
@@ -497,7 +620,7 @@ void emit_move(
             = operand_register(intermediate_register);
 
         emit_instruction_dst_src(
-            assembly_writer,
+            emitter,
             InstructionMov,
             src_operand_width,
             src_operand_width,
@@ -505,7 +628,7 @@ void emit_move(
             src
         );
         emit_instruction_dst_src(
-            assembly_writer,
+            emitter,
             InstructionMov,
             dst_operand_width,
             dst_operand_width,
@@ -516,7 +639,7 @@ void emit_move(
 }
 
 void emit_move_bytes(
-    struct Writer *const assembly_writer, 
+    struct Emitter *const emitter, 
     struct Operand const dst, 
     struct Operand const src, 
     usize const size_bytes,
@@ -526,7 +649,7 @@ void emit_move_bytes(
         enum OperandWidth const operand_width = operand_width_with_size(size_bytes);
 
         emit_move(
-            assembly_writer, 
+            emitter, 
             dst, 
             src, 
             operand_width, 
@@ -548,7 +671,7 @@ void emit_move_bytes(
         // move qwords
         while (bytes_remaining >= 8) {
             emit_move(
-                assembly_writer, 
+                emitter, 
                 operand_dst, 
                 operand_src,
                 QWord,
@@ -564,7 +687,7 @@ void emit_move_bytes(
         // last dword
         if (bytes_remaining >= 4) {
             emit_move(
-                assembly_writer, 
+                emitter, 
                 operand_dst, 
                 operand_src,
                 DWord,
@@ -580,7 +703,7 @@ void emit_move_bytes(
         // last word 
         if (bytes_remaining >= 2) {
             emit_move(
-                assembly_writer, 
+                emitter, 
                 operand_dst, 
                 operand_src,
                 Word,
@@ -596,7 +719,7 @@ void emit_move_bytes(
         // last byte
         if (bytes_remaining >= 1) {
             emit_move(
-                assembly_writer, 
+                emitter, 
                 operand_dst, 
                 operand_src,
                 Byte,
@@ -612,7 +735,7 @@ void emit_move_bytes(
 }
 
 void emit_assignment(
-    struct Writer *const assembly_writer,
+    struct Emitter *const emitter,
     struct Operand const dst,
     struct Operand const src,
     struct Type const dst_type,
@@ -627,7 +750,7 @@ void emit_assignment(
 
     if (type_eq(&dst_type, &src_type)) {
         emit_move_bytes(
-            assembly_writer, 
+            emitter, 
             dst, 
             src, 
             dst_size,
@@ -646,7 +769,7 @@ void emit_assignment(
 
         if (is_nop) {
             emit_move(
-                assembly_writer, 
+                emitter, 
                 dst, 
                 src, 
                 dst_width, 
@@ -657,7 +780,7 @@ void emit_assignment(
             // cdqe
 
             emit_move(
-                assembly_writer,
+                emitter,
                 operand_register(RegisterA),
                 src,
                 src_width,
@@ -665,11 +788,11 @@ void emit_assignment(
                 RegisterA
             );
             emit_instruction(
-                assembly_writer, 
+                emitter, 
                 InstructionCdqe
             );
             emit_move(
-                assembly_writer,
+                emitter,
                 dst,
                 operand_register(RegisterA),
                 dst_width,
@@ -681,7 +804,7 @@ void emit_assignment(
 
             if (dst.kind == OperandRegister) {
                 emit_instruction_dst_src(
-                    assembly_writer, 
+                    emitter, 
                     InstructionMovSx, 
                     dst_width, 
                     src_width, 
@@ -690,7 +813,7 @@ void emit_assignment(
                 );
             } else {
                 emit_instruction_dst_src(
-                    assembly_writer, 
+                    emitter, 
                     InstructionMovSx, 
                     dst_width, 
                     src_width, 
@@ -698,7 +821,7 @@ void emit_assignment(
                     src
                 );
                 emit_move(
-                    assembly_writer,
+                    emitter,
                     dst,
                     operand_register(RegisterA),
                     dst_width,
@@ -711,7 +834,7 @@ void emit_assignment(
 
             if (dst.kind == OperandRegister) {
                 emit_instruction_dst_src(
-                    assembly_writer, 
+                    emitter, 
                     InstructionMovZx, 
                     dst_width, 
                     src_width, 
@@ -720,7 +843,7 @@ void emit_assignment(
                 );
             } else {
                 emit_instruction_dst_src(
-                    assembly_writer, 
+                    emitter, 
                     InstructionMovZx, 
                     dst_width, 
                     src_width, 
@@ -728,7 +851,7 @@ void emit_assignment(
                     src
                 );
                 emit_move(
-                    assembly_writer,
+                    emitter,
                     dst,
                     operand_register(RegisterA),
                     dst_width,
@@ -14,11 +14,11 @@
 //  - left_value is stored in register A
 //  - right_value is stored in register B
 //  - resulting value must be stored in register A
-static void emit_add(struct Writer *const assembly_writer, struct Type const type) {
+static void emit_add(struct Emitter *const emitter, struct Type const type) {
     switch (type.kind) {
         case TypeInteger: {
             emit_instruction_dst_src(
-                assembly_writer, 
+                emitter, 
                 InstructionAdd, 
                 integer_operand_width(type.variant.integer_type.size), 
                 integer_operand_width(type.variant.integer_type.size), 
@@ -34,11 +34,11 @@ static void emit_add(struct Writer *const assembly_writer, struct Type const typ
     }
 }
 
-static void emit_sub(struct Writer *const assembly_writer, struct Type const type) {
+static void emit_sub(struct Emitter *const emitter, struct Type const type) {
     switch (type.kind) {
         case TypeInteger: {
             emit_instruction_dst_src(
-                assembly_writer, 
+                emitter, 
                 InstructionSub, 
                 integer_operand_width(type.variant.integer_type.size), 
                 integer_operand_width(type.variant.integer_type.size), 
@@ -54,11 +54,11 @@ static void emit_sub(struct Writer *const assembly_writer, struct Type const typ
     }
 }
 
-static void emit_mul(struct Writer *const assembly_writer, struct Type const type) {
+static void emit_mul(struct Emitter *const emitter, struct Type const type) {
     switch (type.kind) {
         case TypeInteger: {
             emit_instruction_dst_src(
-                assembly_writer, 
+                emitter, 
                 InstructionIMul, 
                 integer_operand_width(type.variant.integer_type.size), 
                 integer_operand_width(type.variant.integer_type.size), 
@@ -74,12 +74,12 @@ static void emit_mul(struct Writer *const assembly_writer, struct Type const typ
     }
 }
 
-static void emit_div(struct Writer *const assembly_writer, struct Type const type) {
+static void emit_div(struct Emitter *const emitter, struct Type const type) {
     switch (type.kind) {
         case TypeInteger: {
-            emit_instruction(assembly_writer, InstructionCdq);
+            emit_instruction(emitter, InstructionCdq);
             emit_instruction_single_operand(
-                assembly_writer, 
+                emitter, 
                 InstructionIDiv, 
                 integer_operand_width(type.variant.integer_type.size), 
                 operand_register(RegisterB)
@@ -137,7 +137,7 @@ struct CompileResult compile_binary_op(
             = compiler_allocate_temporary_stack_space(compiler, size_bytes);
 
         emit_move(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             operand_dst, 
             left_value.operand, 
             integer_operand_width(left_value.type.variant.integer_type.size),
@@ -178,14 +178,14 @@ struct CompileResult compile_binary_op(
     // move values to registers and perform type conversion
 
     emit_assignment(
-        &compiler->writer_function_body, 
+        &compiler->emitter_text, 
         operand_register(RegisterB), 
         right_value.operand, 
         result_type, 
         right_value.type
     );
     emit_assignment(
-        &compiler->writer_function_body, 
+        &compiler->emitter_text, 
         operand_register(RegisterA), 
         left_value.operand, 
         result_type, 
@@ -196,19 +196,19 @@ struct CompileResult compile_binary_op(
 
     switch (ast->kind) {
         case AstBinaryOpAddition: {
-            emit_add(&compiler->writer_function_body, result_type);
+            emit_add(&compiler->emitter_text, result_type);
             break;
         }
         case AstBinaryOpSubtraction: {
-            emit_sub(&compiler->writer_function_body, result_type);
+            emit_sub(&compiler->emitter_text, result_type);
             break;
         }
         case AstBinaryOpMultiplication: {
-            emit_mul(&compiler->writer_function_body, result_type);
+            emit_mul(&compiler->emitter_text, result_type);
             break;
         }
         case AstBinaryOpDivision: {
-            emit_div(&compiler->writer_function_body, result_type);
+            emit_div(&compiler->emitter_text, result_type);
             break;
         }
         default: {
@@ -58,7 +58,7 @@ struct CompileResult compile_remaining_arguments(
             = compiler_allocate_temporary_stack_space(compiler, size_bytes);
 
         emit_move(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             operand_dst, 
             argument_value.operand, 
             integer_operand_width(parameter_type.variant.integer_type.size), 
@@ -91,7 +91,7 @@ struct CompileResult compile_remaining_arguments(
         // move
 
         emit_assignment(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             argument_location, 
             argument_value.operand,
             parameter_type,
@@ -102,7 +102,7 @@ struct CompileResult compile_remaining_arguments(
 
         if (type_eq(&parameter_type, &argument_value.type)) {
             emit_instruction_single_operand(
-                &compiler->writer_function_body, 
+                &compiler->emitter_text, 
                 InstructionPush,
                 integer_operand_width(parameter_type.variant.integer_type.size), 
                 argument_value.operand
@@ -111,14 +111,14 @@ struct CompileResult compile_remaining_arguments(
             // perform type conversion
             // NB: assumes type fits in register (should be true for C for any coerced type)
             emit_assignment(
-                &compiler->writer_function_body, 
+                &compiler->emitter_text, 
                 operand_register(RegisterA), 
                 argument_value.operand, 
                 parameter_type, 
                 argument_value.type
             );
             emit_instruction_single_operand(
-                &compiler->writer_function_body, 
+                &compiler->emitter_text, 
                 InstructionPush,
                 integer_operand_width(parameter_type.variant.integer_type.size), 
                 operand_register(RegisterA)
@@ -142,7 +142,7 @@ struct CompileResult compile_call(
     struct FunctionDescription function_desc;
     bool exists = function_table_get(
         compiler->function_table, 
-        ast->callee.name, 
+        ast->callee.symbol, 
         &function_desc
     );
 
@@ -187,7 +187,7 @@ struct CompileResult compile_call(
     // emit call 
     
     emit_instruction_single_operand(
-        &compiler->writer_function_body, 
+        &compiler->emitter_text, 
         InstructionCall, 
         QWord, 
         operand_label(function_desc.name)
@@ -197,7 +197,7 @@ struct CompileResult compile_call(
 
     if (argument_location_context.stack_displacement > 0u) {
         emit_instruction_dst_src(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             InstructionAdd, 
             QWord, 
             QWord, 
@@ -10,23 +10,17 @@
 #include "cc/log.h"
 #include "cc/type.h"
 
-void compiler_push_scope(
-    struct Compiler *const self, 
-    struct VariableTable *const out_variable_table
-) {
-    variable_table_init(out_variable_table, self->variable_table);
-    self->variable_table = out_variable_table;
+void compiler_push_scope(struct Compiler *const self) {
+    variable_table_push_scope(self->variable_table);
 }
 
 void compiler_pop_scope(struct Compiler *const self) {
-    if (self->variable_table->parent == NULL) {
+    if (variable_table_scope_depth(self->variable_table) == 0u) {
         log_error("compiler_pop_scope called at global scope");
         exit(1);
     }
 
-    struct VariableTable *const old = self->variable_table;
-    self->variable_table = self->variable_table->parent;
-    variable_table_free(old);
+    variable_table_pop_scope(self->variable_table);
 }
 
 void compiler_init_function_context(
@@ -43,6 +37,7 @@ struct CompileResult compiler_declare_variable(
     struct Compiler *const self, 
     struct VariableDescription *variable_desc_out, 
     struct CharSlice const name, 
+    u32 const symbol,
     struct Type const type,
     struct AstNodePosition const position
 ) {
@@ -57,6 +52,7 @@ struct CompileResult compiler_declare_variable(
     // update variable table
     *variable_desc_out = (struct VariableDescription) {
         .name = name,
+        .symbol = symbol,
         .type = type,
         .stack_offset = self->stack_offset,
     };
@@ -0,0 +1,790 @@
+#include "cc/compile/encoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/compile/assembly.h"
+#include "cc/log.h"
+#include "cc/map.h"
+#include "cc/slice.h"
+#include "cc/vec.h"
+
+// define CodeLabelSlice and CodeLabelVec
+#define SLICE_TYPE CodeLabelSlice
+#define SLICE_ELEMENT_TYPE struct CodeLabel
+#define SLICE_FUNCTION_PREFIX codelabelslice_
+#include "cc/template/slice.inl"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE CodeLabelVec
+#define VEC_ELEMENT_TYPE struct CodeLabel
+#define VEC_SLICE_TYPE CodeLabelSlice
+#define VEC_FUNCTION_PREFIX codelabelvec_
+#include "cc/template/vec.inl"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+// define CodeFixupSlice and CodeFixupVec
+#define SLICE_TYPE CodeFixupSlice
+#define SLICE_ELEMENT_TYPE struct CodeFixup
+#define SLICE_FUNCTION_PREFIX codefixupslice_
+#include "cc/template/slice.inl"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE CodeFixupVec
+#define VEC_ELEMENT_TYPE struct CodeFixup
+#define VEC_SLICE_TYPE CodeFixupSlice
+#define VEC_FUNCTION_PREFIX codefixupvec_
+#include "cc/template/vec.inl"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+#define CODE_BUFFER_LABEL_TABLE_SIZE 64u
+
+#define REX   0x40u
+#define REX_W 0x08u
+#define REX_R 0x04u
+#define REX_X 0x02u
+#define REX_B 0x01u
+
+#define OPERAND_SIZE_PREFIX 0x66u
+
+// hardware number of each register, in the order of enum IntRegister
+static u8 const register_numbers[RegisterCount] = {
+    0u,  // a
+    3u,  // b
+    1u,  // c
+    2u,  // d
+    6u,  // si
+    7u,  // di
+    4u,  // sp
+    5u,  // bp
+    8u,
+    9u,
+    10u,
+    11u,
+    12u,
+    13u,
+    14u,
+    15u,
+};
+
+static u8 register_number(enum IntRegister const reg) {
+    if (reg >= RegisterCount) {
+        log_error("encoder: invalid register: %zu", (usize) reg);
+        exit(1);
+    }
+
+    return register_numbers[reg];
+}
+
+// spl, bpl, sil and dil share their numbers with ah, ch, dh and bh, which are what the numbers
+// mean without a REX prefix
+static bool byte_register_needs_rex(u8 const number) {
+    return number >= 4u && number < 8u;
+}
+
+//--------------------------------------------------------------------------------
+// Code buffer
+//--------------------------------------------------------------------------------
+
+void code_buffer_init(struct CodeBuffer *const self) {
+    charvec_init(&self->bytes);
+    codelabelvec_init(&self->labels);
+    map__charslice_usize__init(&self->label_offsets, CODE_BUFFER_LABEL_TABLE_SIZE);
+    codefixupvec_init(&self->fixups);
+}
+
+void code_buffer_free(struct CodeBuffer *const self) {
+    charvec_free(&self->bytes);
+    codelabelvec_free(&self->labels);
+    map__charslice_usize__free(&self->label_offsets);
+    codefixupvec_free(&self->fixups);
+}
+
+static void code_buffer_push_u8(struct CodeBuffer *const self, u8 const byte) {
+    charvec_push(&self->bytes, (char) byte);
+}
+
+// the low `len` bytes of `value`, least significant first
+static void code_buffer_push_le(struct CodeBuffer *const self, u64 const value, usize const len) {
+    for (usize i = 0u; i < len; i += 1u) {
+        code_buffer_push_u8(self, (u8) (value >> (8u * i)));
+    }
+}
+
+static void code_buffer_write_le(struct CodeBuffer *const self, usize const offset, u64 const value, usize const len) {
+    for (usize i = 0u; i < len; i += 1u) {
+        self->bytes.data[offset + i] = (char) (u8) (value >> (8u * i));
+    }
+}
+
+void code_buffer_define_label(struct CodeBuffer *const self, struct CharSlice const name) {
+    if (map__charslice_usize__contains_key(&self->label_offsets, name)) {
+        log_error("code_buffer_define_label: label %.*s defined twice", (int) name.len, name.ptr);
+        exit(1);
+    }
+
+    map__charslice_usize__set(&self->label_offsets, name, self->bytes.len);
+    codelabelvec_push(
+        &self->labels, 
+        (struct CodeLabel) {
+            .name = name,
+            .offset = self->bytes.len,
+        }
+    );
+}
+
+// writes the displacement from the end of the rel32 field at `offset` to `target`
+static void code_buffer_write_rel32(struct CodeBuffer *const self, usize const offset, usize const target) {
+    i64 const displacement = (i64) target - (i64) (offset + 4u);
+
+    if (displacement < INT32_MIN || displacement > INT32_MAX) {
+        log_error("encoder: branch displacement %ld does not fit in 32 bits", displacement);
+        exit(1);
+    }
+
+    code_buffer_write_le(self, offset, (u64) displacement, 4u);
+}
+
+void code_buffer_resolve_fixups(struct CodeBuffer *const self) {
+    usize kept = 0u;
+
+    for (usize i = 0u; i < self->fixups.len; i += 1u) {
+        struct CodeFixup const fixup = self->fixups.data[i];
+        usize const *const target = map__charslice_usize__get(&self->label_offsets, fixup.label);
+
+        if (target != NULL) {
+            code_buffer_write_rel32(self, fixup.offset, *target);
+        } else {
+            self->fixups.data[kept] = fixup;
+            kept += 1u;
+        }
+    }
+
+    self->fixups.len = kept;
+}
+
+usize code_buffer_reserve(struct CodeBuffer *const self, usize const len) {
+    usize const offset = self->bytes.len;
+
+    charvec_reserve(&self->bytes, len);
+    memset(self->bytes.data + offset, 0, len);
+    self->bytes.len += len;
+
+    return offset;
+}
+
+void code_buffer_patch(struct CodeBuffer *const self, usize const offset, char const *const bytes, usize const len) {
+    if (offset + len > self->bytes.len) {
+        log_error("code_buffer_patch: %zu bytes at %zu are out of range", len, offset);
+        exit(1);
+    }
+
+    memcpy(self->bytes.data + offset, bytes, len);
+}
+
+//--------------------------------------------------------------------------------
+// Operands
+//--------------------------------------------------------------------------------
+
+static usize operand_width_bytes(enum OperandWidth const width) {
+    switch (width) {
+        case Byte:  return 1u;
+        case Word:  return 2u;
+        case DWord: return 4u;
+        case QWord: return 8u;
+        default: {
+            log_error("encoder: invalid operand width: %zu", (usize) width);
+            exit(1);
+        }
+    }
+}
+
+// `value` truncated to `width` and read as a signed number, which is what an immediate of that
+// width means to the instruction (nasm truncates larger values the same way)
+static i64 immediate_signed(u64 const value, enum OperandWidth const width) {
+    switch (width) {
+        case Byte:  return (i64) (i8) (u8) value;
+        case Word:  return (i64) (i16) (u16) value;
+        case DWord: return (i64) (i32) (u32) value;
+        default:    return (i64) value;
+    }
+}
+
+static bool fits_i8(i64 const value) {
+    return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+static bool fits_i32(i64 const value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+// writes the immediate of an instruction with operand width `width`: as many bytes as the
+// width, except that qword instructions take a sign-extended dword
+static void code_buffer_push_immediate(
+    struct CodeBuffer *const self,
+    u64 const value,
+    enum OperandWidth const width
+) {
+    if (width == QWord) {
+        if (!fits_i32((i64) value)) {
+            log_error("encoder: immediate %lu does not fit in a sign-extended dword", value);
+            exit(1);
+        }
+        code_buffer_push_le(self, value, 4u);
+    } else {
+        code_buffer_push_le(self, value, operand_width_bytes(width));
+    }
+}
+
+// ModRM byte, and SIB byte and displacement if needed, addressing [base+index*scale+displacement]
+static void encode_memory(
+    struct CodeBuffer *const self,
+    u8 const reg,
+    u8 const base,
+    bool const has_index,
+    u8 const index,
+    i64 const index_scale,
+    i64 const displacement
+) {
+    if (!fits_i32(displacement)) {
+        log_error("encoder: displacement %ld does not fit in 32 bits", displacement);
+        exit(1);
+    }
+
+    // mod 00 with base rbp or r13 means rip-relative (or no base), so those need a displacement
+    u8 mod;
+    if (displacement == 0 && (base & 7u) != 5u) {
+        mod = 0u;
+    } else if (fits_i8(displacement)) {
+        mod = 1u;
+    } else {
+        mod = 2u;
+    }
+
+    // r/m 100 means a SIB byte follows, so a base of rsp or r12 can only be given through one
+    bool const needs_sib = has_index || (base & 7u) == 4u;
+
+    code_buffer_push_u8(self, (u8) ((mod << 6u) | ((reg & 7u) << 3u) | (needs_sib ? 4u : base & 7u)));
+
+    if (needs_sib) {
+        u8 scale_bits = 0u;
+        u8 index_bits = 4u;
+
+        if (has_index) {
+            if (index == 4u) {
+                log_error("encoder: rsp cannot be an index register");
+                exit(1);
+            }
+
+            switch (index_scale) {
+                case 1: scale_bits = 0u; break;
+                case 2: scale_bits = 1u; break;
+                case 4: scale_bits = 2u; break;
+                case 8: scale_bits = 3u; break;
+                default: {
+                    log_error("encoder: invalid index scale: %ld", index_scale);
+                    exit(1);
+                }
+            }
+            index_bits = index & 7u;
+        }
+
+        code_buffer_push_u8(self, (u8) ((scale_bits << 6u) | (index_bits << 3u) | (base & 7u)));
+    }
+
+    if (mod == 1u) {
+        code_buffer_push_le(self, (u64) displacement, 1u);
+    } else if (mod == 2u) {
+        code_buffer_push_le(self, (u64) displacement, 4u);
+    }
+}
+
+// ModRM byte (and what follows it) for register field `reg` and register or memory operand `rm`
+static void encode_modrm(struct CodeBuffer *const self, u8 const reg, struct Operand const *const rm) {
+    switch (rm->kind) {
+        case OperandRegister: {
+            u8 const number = register_number(rm->variant.int_register.reg);
+            code_buffer_push_u8(self, (u8) (0xc0u | ((reg & 7u) << 3u) | (number & 7u)));
+            return;
+        }
+        case OperandMemory: {
+            encode_memory(
+                self,
+                reg,
+                register_number(rm->variant.memory.base_reg),
+                false,
+                0u,
+                1,
+                rm->variant.memory.displacement
+            );
+            return;
+        }
+        case OperandMemoryIndexed: {
+            encode_memory(
+                self,
+                reg,
+                register_number(rm->variant.memory_indexed.base_reg),
+                true,
+                register_number(rm->variant.memory_indexed.index_reg),
+                rm->variant.memory_indexed.index_scale,
+                rm->variant.memory_indexed.displacement
+            );
+            return;
+        }
+        default: {
+            log_error("encoder: operand of kind %zu is not a register or memory", (usize) rm->kind);
+            exit(1);
+        }
+    }
+}
+
+// REX prefix for the registers of `rm` (0 if none is needed)
+static u8 rex_of_rm(struct Operand const *const rm, bool const rm_is_byte) {
+    switch (rm->kind) {
+        case OperandRegister: {
+            u8 const number = register_number(rm->variant.int_register.reg);
+            u8 rex = (number & 8u) != 0u ? (u8) (REX | REX_B) : 0u;
+            if (rm_is_byte && byte_register_needs_rex(number)) {
+                rex |= REX;
+            }
+            return rex;
+        }
+        case OperandMemory: {
+            return (register_number(rm->variant.memory.base_reg) & 8u) != 0u ? (u8) (REX | REX_B) : 0u;
+        }
+        case OperandMemoryIndexed: {
+            u8 rex = 0u;
+            if ((register_number(rm->variant.memory_indexed.base_reg) & 8u) != 0u) {
+                rex |= REX | REX_B;
+            }
+            if ((register_number(rm->variant.memory_indexed.index_reg) & 8u) != 0u) {
+                rex |= REX | REX_X;
+            }
+            return rex;
+        }
+        default: {
+            return 0u;
+        }
+    }
+}
+
+// prefixes, opcode and ModRM of an instruction whose register field is `reg` (a register number
+// or an opcode extension) and whose r/m operand is `rm`
+// `operand_size` selects the operand size prefix or REX.W, byte operations have their own opcodes
+static void encode_rm(
+    struct CodeBuffer *const self,
+    enum OperandWidth const operand_size,
+    u8 const *const opcode,
+    usize const opcode_len,
+    u8 const reg,
+    bool const reg_is_byte_register,
+    struct Operand const *const rm,
+    bool const rm_is_byte
+) {
+    u8 rex = rex_of_rm(rm, rm_is_byte);
+    if (operand_size == QWord) {
+        rex |= REX | REX_W;
+    }
+    if ((reg & 8u) != 0u) {
+        rex |= REX | REX_R;
+    }
+    if (reg_is_byte_register && byte_register_needs_rex(reg)) {
+        rex |= REX;
+    }
+
+    if (operand_size == Word) {
+        code_buffer_push_u8(self, OPERAND_SIZE_PREFIX);
+    }
+    if (rex != 0u) {
+        code_buffer_push_u8(self, rex);
+    }
+    for (usize i = 0u; i < opcode_len; i += 1u) {
+        code_buffer_push_u8(self, opcode[i]);
+    }
+
+    encode_modrm(self, reg, rm);
+}
+
+static void encode_rm1(
+    struct CodeBuffer *const self,
+    enum OperandWidth const operand_size,
+    u8 const opcode,
+    u8 const reg,
+    bool const reg_is_byte_register,
+    struct Operand const *const rm,
+    bool const rm_is_byte
+) {
+    encode_rm(self, operand_size, &opcode, 1u, reg, reg_is_byte_register, rm, rm_is_byte);
+}
+
+// an instruction with the register number in the low bits of the opcode (push, pop, mov imm)
+static void encode_opcode_register(
+    struct CodeBuffer *const self,
+    enum OperandWidth const operand_size,
+    u8 const opcode,
+    enum IntRegister const reg
+) {
+    u8 const number = register_number(reg);
+
+    u8 rex = (number & 8u) != 0u ? (u8) (REX | REX_B) : 0u;
+    if (operand_size == QWord) {
+        rex |= REX | REX_W;
+    }
+    if (operand_size == Byte && byte_register_needs_rex(number)) {
+        rex |= REX;
+    }
+
+    if (operand_size == Word) {
+        code_buffer_push_u8(self, OPERAND_SIZE_PREFIX);
+    }
+    if (rex != 0u) {
+        code_buffer_push_u8(self, rex);
+    }
+    code_buffer_push_u8(self, (u8) (opcode + (number & 7u)));
+}
+
+static bool operand_is_rm(struct Operand const *const operand) {
+    return operand->kind == OperandRegister
+        || operand->kind == OperandMemory
+        || operand->kind == OperandMemoryIndexed;
+}
+
+static void encode_unsupported(
+    enum Instruction const instruction,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    log_error(
+        "encoder: %s does not take operands of kind %zu, %zu",
+        format_instruction(instruction),
+        (usize) dst->kind,
+        src == NULL ? (usize) 0u : (usize) src->kind
+    );
+    exit(1);
+}
+
+//--------------------------------------------------------------------------------
+// Instructions
+//--------------------------------------------------------------------------------
+
+void encode_instruction(struct CodeBuffer *const self, enum Instruction const instruction) {
+    switch (instruction) {
+        case InstructionLeave: {
+            code_buffer_push_u8(self, 0xc9u);
+            break;
+        }
+        case InstructionRet: {
+            code_buffer_push_u8(self, 0xc3u);
+            break;
+        }
+        case InstructionCdq: {
+            code_buffer_push_u8(self, 0x99u);
+            break;
+        }
+        case InstructionCdqe: {
+            code_buffer_push_u8(self, REX | REX_W);
+            code_buffer_push_u8(self, 0x98u);
+            break;
+        }
+        default: {
+            log_error("encode_instruction: %s takes operands", format_instruction(instruction));
+            exit(1);
+        }
+    }
+}
+
+void encode_instruction_single_operand(
+    struct CodeBuffer *const self,
+    enum Instruction const instruction,
+    enum OperandWidth const operand_width,
+    struct Operand const *const operand
+) {
+    // push, pop and call always work on qwords, without REX.W, so they are given a dword
+    // operand size below
+    switch (instruction) {
+        case InstructionPush: {
+            if (operand->kind == OperandRegister) {
+                encode_opcode_register(self, DWord, 0x50u, operand->variant.int_register.reg);
+            } else if (operand->kind == OperandImmediate) {
+                i64 const value = (i64) operand->variant.immediate.value;
+                if (fits_i8(value)) {
+                    code_buffer_push_u8(self, 0x6au);
+                    code_buffer_push_le(self, (u64) value, 1u);
+                } else {
+                    code_buffer_push_u8(self, 0x68u);
+                    code_buffer_push_immediate(self, (u64) value, QWord);
+                }
+            } else if (operand_is_rm(operand)) {
+                encode_rm1(self, DWord, 0xffu, 6u, false, operand, false);
+            } else {
+                encode_unsupported(instruction, operand, NULL);
+            }
+            break;
+        }
+        case InstructionPop: {
+            if (operand->kind == OperandRegister) {
+                encode_opcode_register(self, DWord, 0x58u, operand->variant.int_register.reg);
+            } else if (operand_is_rm(operand)) {
+                encode_rm1(self, DWord, 0x8fu, 0u, false, operand, false);
+            } else {
+                encode_unsupported(instruction, operand, NULL);
+            }
+            break;
+        }
+        case InstructionCall: {
+            if (operand->kind == OperandLabel) {
+                code_buffer_push_u8(self, 0xe8u);
+                usize const offset = code_buffer_reserve(self, 4u);
+
+                usize const *const target
+                    = map__charslice_usize__get(&self->label_offsets, operand->variant.label.name);
+                if (target != NULL) {
+                    code_buffer_write_rel32(self, offset, *target);
+                } else {
+                    codefixupvec_push(
+                        &self->fixups,
+                        (struct CodeFixup) {
+                            .offset = offset,
+                            .label = operand->variant.label.name,
+                        }
+                    );
+                }
+            } else if (operand_is_rm(operand)) {
+                encode_rm1(self, DWord, 0xffu, 2u, false, operand, false);
+            } else {
+                encode_unsupported(instruction, operand, NULL);
+            }
+            break;
+        }
+        case InstructionIDiv: {
+            if (!operand_is_rm(operand)) {
+                encode_unsupported(instruction, operand, NULL);
+            }
+            bool const is_byte = operand_width == Byte;
+            encode_rm1(self, operand_width, is_byte ? 0xf6u : 0xf7u, 7u, false, operand, is_byte);
+            break;
+        }
+        default: {
+            log_error(
+                "encode_instruction_single_operand: %s does not take one operand",
+                format_instruction(instruction)
+            );
+            exit(1);
+        }
+    }
+}
+
+// add and sub, which only differ in their opcodes
+static void encode_arithmetic(
+    struct CodeBuffer *const self,
+    enum Instruction const instruction,
+    u8 const base_opcode,
+    u8 const extension,
+    enum OperandWidth const width,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    bool const is_byte = width == Byte;
+
+    if (src->kind == OperandImmediate && operand_is_rm(dst)) {
+        u64 const value = src->variant.immediate.value;
+
+        if (is_byte) {
+            encode_rm1(self, width, 0x80u, extension, false, dst, true);
+            code_buffer_push_le(self, value, 1u);
+        } else if (fits_i8(immediate_signed(value, width))) {
+            encode_rm1(self, width, 0x83u, extension, false, dst, false);
+            code_buffer_push_le(self, value, 1u);
+        } else {
+            encode_rm1(self, width, 0x81u, extension, false, dst, false);
+            code_buffer_push_immediate(self, value, width);
+        }
+    } else if (src->kind == OperandRegister && operand_is_rm(dst)) {
+        u8 const opcode = is_byte ? base_opcode : (u8) (base_opcode + 1u);
+        encode_rm1(self, width, opcode, register_number(src->variant.int_register.reg), is_byte, dst, is_byte);
+    } else if (dst->kind == OperandRegister && operand_is_rm(src)) {
+        u8 const opcode = is_byte ? (u8) (base_opcode + 2u) : (u8) (base_opcode + 3u);
+        encode_rm1(self, width, opcode, register_number(dst->variant.int_register.reg), is_byte, src, is_byte);
+    } else {
+        encode_unsupported(instruction, dst, src);
+    }
+}
+
+static void encode_mov(
+    struct CodeBuffer *const self,
+    enum OperandWidth const width,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    bool const is_byte = width == Byte;
+
+    if (src->kind == OperandImmediate && dst->kind == OperandRegister) {
+        u64 const value = src->variant.immediate.value;
+
+        if (width == QWord && fits_i32((i64) value)) {
+            // sign-extended dword, shorter than the full qword form
+            encode_rm1(self, QWord, 0xc7u, 0u, false, dst, false);
+            code_buffer_push_le(self, value, 4u);
+        } else {
+            encode_opcode_register(self, width, is_byte ? 0xb0u : 0xb8u, dst->variant.int_register.reg);
+            code_buffer_push_le(self, value, operand_width_bytes(width));
+        }
+    } else if (src->kind == OperandImmediate && operand_is_rm(dst)) {
+        encode_rm1(self, width, is_byte ? 0xc6u : 0xc7u, 0u, false, dst, false);
+        code_buffer_push_immediate(self, src->variant.immediate.value, width);
+    } else if (src->kind == OperandRegister && operand_is_rm(dst)) {
+        encode_rm1(self, width, is_byte ? 0x88u : 0x89u, register_number(src->variant.int_register.reg), is_byte, dst, is_byte);
+    } else if (dst->kind == OperandRegister && operand_is_rm(src)) {
+        encode_rm1(self, width, is_byte ? 0x8au : 0x8bu, register_number(dst->variant.int_register.reg), is_byte, src, is_byte);
+    } else {
+        encode_unsupported(InstructionMov, dst, src);
+    }
+}
+
+// movsx and movzx, from a byte or word (or for movsx, a dword) to a wider register
+static void encode_extend(
+    struct CodeBuffer *const self,
+    enum Instruction const instruction,
+    enum OperandWidth const dst_width,
+    enum OperandWidth const src_width,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    if (dst->kind != OperandRegister || !operand_is_rm(src)) {
+        encode_unsupported(instruction, dst, src);
+    }
+
+    bool const is_signed = instruction == InstructionMovSx;
+    u8 const reg = register_number(dst->variant.int_register.reg);
+
+    switch (src_width) {
+        case Byte:
+        case Word: {
+            u8 const opcode[2] = {
+                0x0fu,
+                (u8) ((is_signed ? 0xbeu : 0xb6u) + (src_width == Word ? 1u : 0u)),
+            };
+            encode_rm(self, dst_width, opcode, 2u, reg, false, src, src_width == Byte);
+            break;
+        }
+        case DWord: {
+            if (dst_width != QWord) {
+                encode_unsupported(instruction, dst, src);
+            }
+
+            if (is_signed) {
+                // movsxd
+                encode_rm1(self, QWord, 0x63u, reg, false, src, false);
+            } else {
+                // writing a dword register clears the upper half
+                encode_rm1(self, DWord, 0x8bu, reg, false, src, false);
+            }
+            break;
+        }
+        default: {
+            encode_unsupported(instruction, dst, src);
+        }
+    }
+}
+
+static void encode_imul(
+    struct CodeBuffer *const self,
+    enum OperandWidth const width,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    if (dst->kind != OperandRegister || width == Byte) {
+        encode_unsupported(InstructionIMul, dst, src);
+    }
+
+    u8 const reg = register_number(dst->variant.int_register.reg);
+
+    if (src->kind == OperandImmediate) {
+        // the three operand form, with the destination as the source as well
+        u64 const value = src->variant.immediate.value;
+
+        if (fits_i8(immediate_signed(value, width))) {
+            encode_rm1(self, width, 0x6bu, reg, false, dst, false);
+            code_buffer_push_le(self, value, 1u);
+        } else {
+            encode_rm1(self, width, 0x69u, reg, false, dst, false);
+            code_buffer_push_immediate(self, value, width);
+        }
+    } else if (operand_is_rm(src)) {
+        u8 const opcode[2] = { 0x0fu, 0xafu };
+        encode_rm(self, width, opcode, 2u, reg, false, src, false);
+    } else {
+        encode_unsupported(InstructionIMul, dst, src);
+    }
+}
+
+void encode_instruction_dst_src(
+    struct CodeBuffer *const self,
+    enum Instruction const instruction,
+    enum OperandWidth const dst_width,
+    enum OperandWidth const src_width,
+    struct Operand const *const dst,
+    struct Operand const *const src
+) {
+    switch (instruction) {
+        case InstructionMov: {
+            encode_mov(self, dst_width, dst, src);
+            break;
+        }
+        case InstructionMovSx:
+        case InstructionMovZx: {
+            encode_extend(self, instruction, dst_width, src_width, dst, src);
+            break;
+        }
+        case InstructionAdd: {
+            encode_arithmetic(self, instruction, 0x00u, 0u, dst_width, dst, src);
+            break;
+        }
+        case InstructionSub: {
+            encode_arithmetic(self, instruction, 0x28u, 5u, dst_width, dst, src);
+            break;
+        }
+        case InstructionIMul: {
+            encode_imul(self, dst_width, dst, src);
+            break;
+        }
+        default: {
+            log_error(
+                "encode_instruction_dst_src: %s does not take two operands",
+                format_instruction(instruction)
+            );
+            exit(1);
+        }
+    }
+}
+
+void encode_stack_adjustment(char out[ENCODED_STACK_ADJUSTMENT_LEN], usize const frame_size) {
+    if (frame_size == 0u) {
+        // nop dword [rax+0]
+        u8 const nop[ENCODED_STACK_ADJUSTMENT_LEN] = { 0x0fu, 0x1fu, 0x80u, 0x00u, 0x00u, 0x00u, 0x00u };
+        memcpy(out, nop, ENCODED_STACK_ADJUSTMENT_LEN);
+        return;
+    }
+
+    if (frame_size > (usize) INT32_MAX) {
+        log_error("encode_stack_adjustment: stack frame of %zu bytes is too large", frame_size);
+        exit(1);
+    }
+
+    // sub rsp, imm32
+    u8 const sub[3] = { REX | REX_W, 0x81u, 0xecu };
+    memcpy(out, sub, sizeof (sub));
+    for (usize i = 0u; i < 4u; i += 1u) {
+        out[sizeof (sub) + i] = (char) (u8) (frame_size >> (8u * i));
+    }
+}
@@ -1,6 +1,7 @@
 #include "cc/compile/error.h"
 
 #include "cc/common.h"
+#include "cc/source_map.h"
 #include "cc/type.h"
 #include "cc/writer.h"
 
@@ -17,14 +18,23 @@ struct CompileResult compile_error(struct CompileError const error) {
     };
 }
 
-void format_compile_error(struct Writer *const writer, struct CompileError const *const error) {
+void format_compile_error(
+    struct Writer *const writer, 
+    struct SourceMap *const sources,
+    struct CompileError const *const error
+) {
+    struct SourceLineColumn const start 
+        = source_map_line_column(sources, error->position.position_start);
+    struct SourceLineColumn const end 
+        = source_map_line_column(sources, error->position.position_end);
+
     writer_writef(
         writer, 
         "(%zu:%zu-%zu:%zu) ", 
-        error->position.position_start.line,
-        error->position.position_start.character,
-        error->position.position_end.line,
-        error->position.position_end.character
+        start.line,
+        start.column,
+        end.line,
+        end.column
     );
 
     switch (error->kind) {
@@ -27,7 +27,7 @@ static struct CompileResult compile_identifier(
     struct VariableDescription variable_desc;
     bool exists = variable_table_lookup(
         compiler->variable_table, 
-        ast->name, 
+        ast->symbol, 
         &variable_desc
     );
 
@@ -92,7 +92,7 @@ static struct CompileResult compile_assignment(
     struct VariableDescription variable_desc;
     bool exists = variable_table_lookup(
         compiler->variable_table, 
-        ast->assignee.identifier.name, 
+        ast->assignee.identifier.symbol, 
         &variable_desc
     );
     if (!exists) {
@@ -126,7 +126,7 @@ static struct CompileResult compile_assignment(
     // emit assignment 
 
     emit_assignment(
-        &compiler->writer_function_body, 
+        &compiler->emitter_text, 
         operand_stack(variable_desc.stack_offset), 
         expression_value.operand, 
         variable_desc.type, 
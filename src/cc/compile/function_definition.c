@@ -34,6 +34,7 @@ static struct CompileResult compile_function_parameters(
             compiler, 
             &variable_desc, 
             parameter->name, 
+            parameter->symbol,
             parameter->type,
             parameter->ast_node_position
         );
@@ -46,7 +47,7 @@ static struct CompileResult compile_function_parameters(
             = locate_next_argument(&argument_location_context, &variable_desc.type);
 
         emit_assignment(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             operand_stack(variable_desc.stack_offset), 
             operand_src,
             parameter->type,
@@ -73,7 +74,13 @@ struct CompileResult compile_function_definition(
     // register function definition
 
     struct CharSlice const name = ast->signature.identifier.name;
-    result = function_table_define(compiler->function_table, name, &signature, ast->position);
+    result = function_table_define(
+        compiler->function_table, 
+        name, 
+        ast->signature.identifier.symbol, 
+        &signature, 
+        ast->position
+    );
 
     if (!result.ok) return result;
 
@@ -81,15 +88,14 @@ struct CompileResult compile_function_definition(
 
     compiler_init_function_context(compiler, &signature.return_type);
 
-    struct VariableTable variable_table;
-    compiler_push_scope(compiler, &variable_table);
+    compiler_push_scope(compiler);
 
-    // compile function body
+    // the body goes straight after the prologue, whose stack adjustment is patched in at the end
 
-    struct CharVec body_text;
-    charvec_init(&body_text);
+    emit_label(&compiler->emitter_text, name);
+    struct EmitterPlaceholder const prologue = emit_function_prologue(&compiler->emitter_text);
 
-    compiler->writer_function_body = charvec_writer(&body_text);
+    // compile function body
 
     result = compile_function_parameters(compiler, &signature);
     if (!result.ok) return result;
@@ -107,23 +113,18 @@ struct CompileResult compile_function_definition(
         missing_return = last_statement->kind != AstStatementReturn;
     }
     if (missing_return) {
-        emit_function_exit(&compiler->writer_function_body);
+        emit_function_exit(&compiler->emitter_text);
     }
 
     // restore compiler state
 
     compiler_pop_scope(compiler);
 
-    // emit code
-
-    emit_label(&compiler->writer_text, name);
-    emit_function_prologue(&compiler->writer_text, compiler->stack_offset_max);
-    writer_write_charslice(&compiler->writer_text, charvec_slice_whole(&body_text));
+    patch_function_prologue(&compiler->emitter_text, prologue, compiler->stack_offset_max);
 
     // cleanup
 
     function_signature_free(&signature);
-    charvec_free(&body_text);
 
     return compile_ok();
 }
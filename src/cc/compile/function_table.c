@@ -17,39 +17,41 @@
 #define VEC_ELEMENT_TYPE struct FunctionDescription 
 #define VEC_SLICE_TYPE FunctionDescriptionSlice
 #define VEC_FUNCTION_PREFIX fdvec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.inl"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
 
-#define FUNCTION_INDEX_SIZE 1021u
+#define FUNCTION_INDEX_SIZE 64u
 
 static void function_table_set(
     struct FunctionTable *const self, 
     struct FunctionDescription const function_desc
 ) {
-    usize const *const existing_index = map__charslice_usize__get(
+    usize const *const existing_index = map__u32_usize__get(
         &self->function_index, 
-        function_desc.name
+        function_desc.symbol
     );
 
     if (existing_index != NULL) {
         *fdvec_at(&self->function_descriptions, *existing_index) = function_desc;
     } else {
-        map__charslice_usize__set(
+        map__u32_usize__set(
             &self->function_index,
-            function_desc.name, 
+            function_desc.symbol, 
             self->function_descriptions.len
         );
         fdvec_push(&self->function_descriptions, function_desc);
     }
 }
 
-void function_table_init(struct FunctionTable *const self) {
-    map__charslice_usize__init(&self->function_index, FUNCTION_INDEX_SIZE);
-    fdvec_init(&self->function_descriptions);
+void function_table_init(struct FunctionTable *const self, struct Allocator const *const allocator) {
+    map__u32_usize__init_in(&self->function_index, FUNCTION_INDEX_SIZE, allocator);
+    fdvec_init_in(&self->function_descriptions, allocator);
 }
 
 void function_table_free(struct FunctionTable *const self) {
@@ -58,20 +60,20 @@ void function_table_free(struct FunctionTable *const self) {
         function_signature_free(&fdvec_at(&self->function_descriptions, i)->signature);
     }
 
-    map__charslice_usize__free(&self->function_index);
+    map__u32_usize__free(&self->function_index);
     fdvec_free(&self->function_descriptions);
 }
 
-bool function_table_has(struct FunctionTable *const self, struct CharSlice const name) {
-    return map__charslice_usize__get(&self->function_index, name) != NULL;
+bool function_table_has(struct FunctionTable *const self, u32 const symbol) {
+    return map__u32_usize__get(&self->function_index, symbol) != NULL;
 }
 
 bool function_table_get(
     struct FunctionTable const *const self, 
-    struct CharSlice const name, 
+    u32 const symbol, 
     struct FunctionDescription *const out
 ) {
-    usize const *const index = map__charslice_usize__get(&self->function_index, name);
+    usize const *const index = map__u32_usize__get(&self->function_index, symbol);
 
     if (index != NULL) {
         *out = *fdvec_at(&self->function_descriptions, *index);
@@ -84,12 +86,13 @@ bool function_table_get(
 struct CompileResult function_table_declare(
     struct FunctionTable *self, 
     struct CharSlice name, 
+    u32 symbol,
     struct FunctionSignature const *signature,
     struct AstNodePosition const position
 ) {
     struct FunctionDescription existing_function_desc;
 
-    if (function_table_get(self, name, &existing_function_desc)) {
+    if (function_table_get(self, symbol, &existing_function_desc)) {
         if (!function_signatures_match(&existing_function_desc.signature, signature)) {
             return compile_error(
                 (struct CompileError) {
@@ -104,6 +107,7 @@ struct CompileResult function_table_declare(
     } else {
         struct FunctionDescription const function_desc = {
             .name = name, 
+            .symbol = symbol,
             .signature = function_signature_clone(signature),
             .has_definition = true,
         };
@@ -116,12 +120,13 @@ struct CompileResult function_table_declare(
 struct CompileResult function_table_define(
     struct FunctionTable *self, 
     struct CharSlice name, 
+    u32 symbol,
     struct FunctionSignature const *signature,
     struct AstNodePosition const position
 ) {
     struct FunctionDescription existing_function_desc;
 
-    if (function_table_get(self, name, &existing_function_desc)) {
+    if (function_table_get(self, symbol, &existing_function_desc)) {
         if (!function_signatures_match(&existing_function_desc.signature, signature)) {
             return compile_error(
                 (struct CompileError) {
@@ -144,11 +149,12 @@ struct CompileResult function_table_define(
             );
         }
 
-        usize const index = *map__charslice_usize__get(&self->function_index, name);
+        usize const index = *map__u32_usize__get(&self->function_index, symbol);
         fdvec_at(&self->function_descriptions, index)->has_definition = true;
     } else {
         struct FunctionDescription const function_desc = {
             .name = name, 
+            .symbol = symbol,
             .signature = function_signature_clone(signature),
             .has_definition = true,
         };
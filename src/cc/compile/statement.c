@@ -27,6 +27,7 @@ static struct CompileResult compile_variable_declaration(
         compiler, 
         &variable_desc,
         ast->identifier.name,
+        ast->identifier.symbol,
         type,
         ast->position
     );
@@ -62,7 +63,7 @@ static struct CompileResult compile_variable_declaration(
         // emit assignment
 
         emit_assignment(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             operand_stack(variable_desc.stack_offset),
             expression_value.operand,
             variable_desc.type,
@@ -104,13 +105,13 @@ static struct CompileResult compile_return_statement(
         // emit assignment
 
         emit_assignment(
-            &compiler->writer_function_body, 
+            &compiler->emitter_text, 
             operand_register(RegisterA),
             expression_value.operand,
             *compiler->function_return_type,
             expression_value.type
         );
-        emit_function_exit(&compiler->writer_function_body);
+        emit_function_exit(&compiler->emitter_text);
     }
 
     return compile_ok();
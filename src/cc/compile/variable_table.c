@@ -1,36 +1,92 @@
 #include "cc/compile/variable_table.h"
 
+#include <stdlib.h>
+
 #include "cc/ast.h"
 #include "cc/compile/error.h"
-#include "cc/hash.h"
-
-#define MAP_TYPE            Map__CharSlice_VariableDescription
-#define MAP_KEY_TYPE        struct CharSlice 
-#define MAP_VALUE_TYPE      struct VariableDescription
-#define MAP_FUNCTION_PREFIX map__charslice_variabledescription__
-#define MAP_KEY_EQ_FN       charslice_eq
-#define MAP_KEY_HASH_FN     charslice_hash_djb2
-#include "cc/template/map.inl"
+#include "cc/interner.h"
+#include "cc/log.h"
+
+#define MAP_TYPE            Map__u32_VariableBinding
+#define MAP_KEY_TYPE        u32
+#define MAP_VALUE_TYPE      struct VariableBinding
+#define MAP_FUNCTION_PREFIX map__u32_variablebinding__
+#define MAP_KEY_EQ_FN       symbol_eq
+#define MAP_KEY_HASH_FN     symbol_hash
+#define MAP_ALLOCATOR
+#include "cc/template/flat_map.inl"
 #undef MAP_TYPE            
 #undef MAP_KEY_TYPE 
 #undef MAP_VALUE_TYPE      
 #undef MAP_FUNCTION_PREFIX 
 #undef MAP_KEY_EQ_FN       
 #undef MAP_KEY_HASH_FN     
+#undef MAP_ALLOCATOR
 
-#define VARIABLE_TABLE_INDEX_SIZE 91
+// define VariableTableUndoSlice and VariableTableUndoVec
+#define SLICE_TYPE VariableTableUndoSlice 
+#define SLICE_ELEMENT_TYPE struct VariableTableUndo 
+#define SLICE_FUNCTION_PREFIX variabletableundoslice_
+#include "cc/template/slice.inl"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
 
+#define VEC_TYPE VariableTableUndoVec 
+#define VEC_ELEMENT_TYPE struct VariableTableUndo 
+#define VEC_SLICE_TYPE VariableTableUndoSlice
+#define VEC_FUNCTION_PREFIX variabletableundovec_
+#define VEC_ALLOCATOR
+#include "cc/template/vec.inl"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
-void variable_table_init(
-    struct VariableTable *const self, 
-    struct VariableTable *const parent
-) {
-    map__charslice_variabledescription__init(&self->variable_index, VARIABLE_TABLE_INDEX_SIZE);
-    self->parent = parent;
+#define VARIABLE_TABLE_INDEX_SIZE 64u
+
+void variable_table_init(struct VariableTable *const self, struct Allocator const *const allocator) {
+    map__u32_variablebinding__init_in(&self->variable_index, VARIABLE_TABLE_INDEX_SIZE, allocator);
+    variabletableundovec_init_in(&self->undo_log, allocator);
+    usizevec_init_in(&self->scope_starts, allocator);
 }
 
 void variable_table_free(struct VariableTable *const self) {
-    map__charslice_variabledescription__free(&self->variable_index);
+    map__u32_variablebinding__free(&self->variable_index);
+    variabletableundovec_free(&self->undo_log);
+    usizevec_free(&self->scope_starts);
+}
+
+void variable_table_push_scope(struct VariableTable *const self) {
+    usizevec_push(&self->scope_starts, self->undo_log.len);
+}
+
+// forgets the variables declared in the innermost scope, making the ones they shadowed 
+// visible again
+void variable_table_pop_scope(struct VariableTable *const self) {
+    if (self->scope_starts.len == 0u) {
+        log_error("variable_table_pop_scope called at global scope");
+        exit(1);
+    }
+
+    usize const scope_start = usizevec_pop_back(&self->scope_starts);
+
+    // undo in reverse, in case a symbol was logged more than once
+    while (self->undo_log.len > scope_start) {
+        struct VariableTableUndo const undo = variabletableundovec_pop_back(&self->undo_log);
+
+        if (undo.has_previous) {
+            map__u32_variablebinding__set(&self->variable_index, undo.symbol, undo.previous);
+        } else {
+            map__u32_variablebinding__remove(&self->variable_index, undo.symbol);
+        }
+    }
+}
+
+// number of scopes pushed on top of the global scope
+usize variable_table_scope_depth(struct VariableTable const *const self) {
+    return self->scope_starts.len;
 }
 
 struct CompileResult variable_table_update(
@@ -38,7 +94,11 @@ struct CompileResult variable_table_update(
     struct VariableDescription const variable_desc,
     struct AstNodePosition const position
 ) {
-    if (variable_table_has(self, variable_desc.name)) {
+    struct VariableBinding *const previous 
+        = map__u32_variablebinding__get(&self->variable_index, variable_desc.symbol);
+    usize const scope_depth = variable_table_scope_depth(self);
+
+    if (previous != NULL && previous->scope_depth == scope_depth) {
         return compile_error((struct CompileError) {
             .kind = CompileErrorVariableRedeclaration,
             .position = position,
@@ -48,40 +108,50 @@ struct CompileResult variable_table_update(
         });
     }
 
-    map__charslice_variabledescription__set(
+    // global declarations are never undone
+    if (scope_depth != 0u) {
+        struct VariableTableUndo undo = {
+            .symbol = variable_desc.symbol,
+            .has_previous = previous != NULL,
+        };
+        if (previous != NULL) {
+            undo.previous = *previous;
+        }
+        variabletableundovec_push(&self->undo_log, undo);
+    }
+
+    map__u32_variablebinding__set(
         &self->variable_index,
-        variable_desc.name,
-        variable_desc
+        variable_desc.symbol,
+        (struct VariableBinding) {
+            .description = variable_desc,
+            .scope_depth = scope_depth,
+        }
     );
 
     return compile_ok();
 }
 
-bool variable_table_has(struct VariableTable const *const self, struct CharSlice const name) {
-    return map__charslice_variabledescription__contains_key(
-        &self->variable_index,
-        name
-    );
+// whether `symbol` is declared in the innermost scope
+bool variable_table_has(struct VariableTable const *const self, u32 const symbol) {
+    struct VariableBinding const *const binding 
+        = map__u32_variablebinding__get(&self->variable_index, symbol);
+
+    return binding != NULL && binding->scope_depth == variable_table_scope_depth(self);
 }
 
 bool variable_table_lookup(
     struct VariableTable const *const self, 
-    struct CharSlice name, 
+    u32 const symbol, 
     struct VariableDescription *const out
 ) {
-    struct VariableTable const *current = self;
-
-    while (current != NULL) {
-        struct VariableDescription const *const variable_description 
-            = map__charslice_variabledescription__get(&current->variable_index, name);
-
-        if (variable_description != NULL) {
-            *out = *variable_description;
-            return true;
-        }
+    struct VariableBinding const *const binding 
+        = map__u32_variablebinding__get(&self->variable_index, symbol);
 
-        current = current->parent;
+    if (binding == NULL) {
+        return false;
     }
 
-    return false;
+    *out = binding->description;
+    return true;
 }
@@ -0,0 +1,320 @@
+#include "cc/elf_object.h"
+
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/common.h"
+#include "cc/compile/encoder.h"
+#include "cc/log.h"
+#include "cc/map.h"
+#include "cc/slice.h"
+#include "cc/vec.h"
+#include "cc/writer.h"
+
+#define ELF_OBJECT_EXTERNAL_TABLE_SIZE 64u
+
+enum ObjectSectionIndex {
+    ObjectSectionNull,
+    ObjectSectionText,
+    ObjectSectionData,
+    ObjectSectionRodata,
+    ObjectSectionBss,
+    ObjectSectionNoteGnuStack,
+    ObjectSectionSymtab,
+    ObjectSectionStrtab,
+    ObjectSectionRelaText,
+    ObjectSectionShstrtab,
+    ObjectSectionCount,
+};
+
+// symbol table index of the first global symbol: the null symbol and one symbol for each
+// allocated section come before it
+#define ELF_OBJECT_FIRST_GLOBAL_SYMBOL 5u
+
+static char const *const section_names[ObjectSectionCount] = {
+    "",
+    ".text",
+    ".data",
+    ".rodata",
+    ".bss",
+    ".note.GNU-stack",
+    ".symtab",
+    ".strtab",
+    ".rela.text",
+    ".shstrtab",
+};
+
+// appends a null-terminated name to a string table and returns its offset
+static u32 string_table_add(struct CharVec *const table, struct CharSlice const name) {
+    usize const offset = table->len;
+
+    charvec_push_slice(table, name);
+    charvec_push(table, '\0');
+
+    if (offset > UINT32_MAX) {
+        log_error("elf_write_object: string table is too large");
+        exit(1);
+    }
+
+    return (u32) offset;
+}
+
+// one global symbol for each label of `code`, sized up to the next label (or the end)
+static void add_label_symbols(
+    Elf64_Sym *const symbols,
+    usize *const symbol_count,
+    struct CharVec *const strtab,
+    struct CodeBuffer const *const code,
+    u16 const section_index,
+    u8 const symbol_type
+) {
+    if (code == NULL) {
+        return;
+    }
+
+    for (usize i = 0u; i < code->labels.len; i += 1u) {
+        struct CodeLabel const *const label = &code->labels.data[i];
+        usize const end = i + 1u < code->labels.len
+            ? code->labels.data[i + 1u].offset
+            : code->bytes.len;
+
+        symbols[*symbol_count] = (Elf64_Sym) {
+            .st_name = string_table_add(strtab, label->name),
+            .st_info = ELF64_ST_INFO(STB_GLOBAL, symbol_type),
+            .st_other = STV_DEFAULT,
+            .st_shndx = section_index,
+            .st_value = label->offset,
+            .st_size = end - label->offset,
+        };
+        *symbol_count += 1u;
+    }
+}
+
+static usize code_len(struct CodeBuffer const *const code) {
+    return code == NULL ? 0u : code->bytes.len;
+}
+
+// pads the output with zeros from `*position` up to `offset`
+static void write_padding(struct Writer *const writer, usize *const position, usize const offset) {
+    static char const zeros[16] = { 0 };
+
+    while (*position < offset) {
+        usize const len = min_usize(offset - *position, sizeof (zeros));
+        writer_write_bytes(writer, zeros, len);
+        *position += len;
+    }
+}
+
+void elf_write_object(struct Writer *const writer, struct ObjectSections const *const sections) {
+    struct CodeBuffer const *const text = sections->text;
+
+    if (sections->data != NULL && sections->data->fixups.len > 0u) {
+        log_error("elf_write_object: the data section refers to undefined labels");
+        exit(1);
+    }
+    if (sections->rodata != NULL && sections->rodata->fixups.len > 0u) {
+        log_error("elf_write_object: the read-only data section refers to undefined labels");
+        exit(1);
+    }
+
+    // symbols: null, sections, labels, then the functions called but not defined here
+
+    usize const symbol_capacity
+        = ELF_OBJECT_FIRST_GLOBAL_SYMBOL
+        + text->labels.len
+        + (sections->data == NULL ? 0u : sections->data->labels.len)
+        + (sections->rodata == NULL ? 0u : sections->rodata->labels.len)
+        + text->fixups.len;
+
+    Elf64_Sym *const symbols = calloc(symbol_capacity, sizeof (Elf64_Sym));
+    Elf64_Rela *const relocations = calloc(max_usize(text->fixups.len, 1u), sizeof (Elf64_Rela));
+    if (symbols == NULL || relocations == NULL) {
+        log_error("elf_write_object: cannot allocate symbol table");
+        exit(1);
+    }
+
+    struct CharVec strtab;
+    charvec_init(&strtab);
+    charvec_push(&strtab, '\0');
+
+    usize symbol_count = 1u;
+    for (u16 section = ObjectSectionText; section <= ObjectSectionBss; section += 1u) {
+        symbols[symbol_count] = (Elf64_Sym) {
+            .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION),
+            .st_shndx = section,
+        };
+        symbol_count += 1u;
+    }
+
+    add_label_symbols(symbols, &symbol_count, &strtab, text, ObjectSectionText, STT_FUNC);
+    add_label_symbols(symbols, &symbol_count, &strtab, sections->data, ObjectSectionData, STT_OBJECT);
+    add_label_symbols(symbols, &symbol_count, &strtab, sections->rodata, ObjectSectionRodata, STT_OBJECT);
+
+    // calls out of the object go through the PLT, so that they can be resolved to a shared library
+    struct Map__CharSlice_usize externals;
+    map__charslice_usize__init(&externals, ELF_OBJECT_EXTERNAL_TABLE_SIZE);
+
+    for (usize i = 0u; i < text->fixups.len; i += 1u) {
+        struct CodeFixup const *const fixup = &text->fixups.data[i];
+
+        usize const *const existing = map__charslice_usize__get(&externals, fixup->label);
+        usize symbol;
+        if (existing != NULL) {
+            symbol = *existing;
+        } else {
+            symbol = symbol_count;
+            symbols[symbol_count] = (Elf64_Sym) {
+                .st_name = string_table_add(&strtab, fixup->label),
+                .st_info = ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE),
+                .st_shndx = SHN_UNDEF,
+            };
+            symbol_count += 1u;
+            map__charslice_usize__set(&externals, fixup->label, symbol);
+        }
+
+        // the field is relative to its own end
+        relocations[i] = (Elf64_Rela) {
+            .r_offset = fixup->offset,
+            .r_info = ELF64_R_INFO(symbol, R_X86_64_PLT32),
+            .r_addend = -4,
+        };
+    }
+
+    map__charslice_usize__free(&externals);
+
+    struct CharVec shstrtab;
+    charvec_init(&shstrtab);
+    charvec_push(&shstrtab, '\0');
+
+    u32 name_offsets[ObjectSectionCount] = { 0u };
+    for (usize section = 1u; section < ObjectSectionCount; section += 1u) {
+        name_offsets[section] = string_table_add(&shstrtab, charslice_from_cstr(section_names[section]));
+    }
+
+    // section headers, laid out one after the other after the file header
+
+    Elf64_Shdr headers[ObjectSectionCount];
+    memset(headers, 0, sizeof (headers));
+
+    headers[ObjectSectionText] = (Elf64_Shdr) {
+        .sh_type = SHT_PROGBITS,
+        .sh_flags = SHF_ALLOC | SHF_EXECINSTR,
+        .sh_size = text->bytes.len,
+        .sh_addralign = 16u,
+    };
+    headers[ObjectSectionData] = (Elf64_Shdr) {
+        .sh_type = SHT_PROGBITS,
+        .sh_flags = SHF_ALLOC | SHF_WRITE,
+        .sh_size = code_len(sections->data),
+        .sh_addralign = 8u,
+    };
+    headers[ObjectSectionRodata] = (Elf64_Shdr) {
+        .sh_type = SHT_PROGBITS,
+        .sh_flags = SHF_ALLOC,
+        .sh_size = code_len(sections->rodata),
+        .sh_addralign = 8u,
+    };
+    headers[ObjectSectionBss] = (Elf64_Shdr) {
+        .sh_type = SHT_NOBITS,
+        .sh_flags = SHF_ALLOC | SHF_WRITE,
+        .sh_size = sections->bss_len,
+        .sh_addralign = 8u,
+    };
+    // empty, marks the object as not needing an executable stack
+    headers[ObjectSectionNoteGnuStack] = (Elf64_Shdr) {
+        .sh_type = SHT_PROGBITS,
+        .sh_addralign = 1u,
+    };
+    headers[ObjectSectionSymtab] = (Elf64_Shdr) {
+        .sh_type = SHT_SYMTAB,
+        .sh_size = symbol_count * sizeof (Elf64_Sym),
+        .sh_link = ObjectSectionStrtab,
+        .sh_info = ELF_OBJECT_FIRST_GLOBAL_SYMBOL,
+        .sh_addralign = 8u,
+        .sh_entsize = sizeof (Elf64_Sym),
+    };
+    headers[ObjectSectionStrtab] = (Elf64_Shdr) {
+        .sh_type = SHT_STRTAB,
+        .sh_size = strtab.len,
+        .sh_addralign = 1u,
+    };
+    headers[ObjectSectionRelaText] = (Elf64_Shdr) {
+        .sh_type = SHT_RELA,
+        .sh_flags = SHF_INFO_LINK,
+        .sh_size = text->fixups.len * sizeof (Elf64_Rela),
+        .sh_link = ObjectSectionSymtab,
+        .sh_info = ObjectSectionText,
+        .sh_addralign = 8u,
+        .sh_entsize = sizeof (Elf64_Rela),
+    };
+    headers[ObjectSectionShstrtab] = (Elf64_Shdr) {
+        .sh_type = SHT_STRTAB,
+        .sh_size = shstrtab.len,
+        .sh_addralign = 1u,
+    };
+
+    char const *const contents[ObjectSectionCount] = {
+        [ObjectSectionText] = text->bytes.data,
+        [ObjectSectionData] = sections->data == NULL ? NULL : sections->data->bytes.data,
+        [ObjectSectionRodata] = sections->rodata == NULL ? NULL : sections->rodata->bytes.data,
+        [ObjectSectionSymtab] = (char const *) symbols,
+        [ObjectSectionStrtab] = strtab.data,
+        [ObjectSectionRelaText] = (char const *) relocations,
+        [ObjectSectionShstrtab] = shstrtab.data,
+    };
+
+    usize offset = sizeof (Elf64_Ehdr);
+    for (usize section = 1u; section < ObjectSectionCount; section += 1u) {
+        offset = round_up_usize(offset, headers[section].sh_addralign);
+        headers[section].sh_name = name_offsets[section];
+        headers[section].sh_offset = offset;
+
+        if (headers[section].sh_type != SHT_NOBITS) {
+            offset += headers[section].sh_size;
+        }
+    }
+    usize const section_headers_offset = round_up_usize(offset, 8u);
+
+    Elf64_Ehdr const header = {
+        .e_ident = {
+            ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3,
+            ELFCLASS64,
+            ELFDATA2LSB,
+            EV_CURRENT,
+            ELFOSABI_SYSV,
+        },
+        .e_type = ET_REL,
+        .e_machine = EM_X86_64,
+        .e_version = EV_CURRENT,
+        .e_shoff = section_headers_offset,
+        .e_ehsize = sizeof (Elf64_Ehdr),
+        .e_shentsize = sizeof (Elf64_Shdr),
+        .e_shnum = ObjectSectionCount,
+        .e_shstrndx = ObjectSectionShstrtab,
+    };
+
+    // write it all out in file order
+
+    usize position = 0u;
+    writer_write_bytes(writer, (char const *) &header, sizeof (header));
+    position += sizeof (header);
+
+    for (usize section = 1u; section < ObjectSectionCount; section += 1u) {
+        if (headers[section].sh_type == SHT_NOBITS || headers[section].sh_size == 0u) {
+            continue;
+        }
+
+        write_padding(writer, &position, headers[section].sh_offset);
+        writer_write_bytes(writer, contents[section], headers[section].sh_size);
+        position += headers[section].sh_size;
+    }
+
+    write_padding(writer, &position, section_headers_offset);
+    writer_write_bytes(writer, (char const *) headers, sizeof (headers));
+
+    charvec_free(&shstrtab);
+    charvec_free(&strtab);
+    free(relocations);
+    free(symbols);
+}
@@ -1,12 +1,91 @@
 #include "cc/hash.h"
 
-usize charslice_hash_djb2(struct CharSlice const s) {
-    usize hash = 5381;
+#include <string.h>
 
-    for (usize i = 0; i < s.len; ++i) {
-        char const c = s.ptr[i];
-        hash = ((hash << 5) + hash) + c;
+static u64 const hash_secret[4] = {
+    0x2d358dccaa6c78a5u, 
+    0x8bb84b93962eacc9u, 
+    0x4b33a62ed433d4a3u, 
+    0x4d5a2da51de1aa47u,
+};
+
+// 64x64 -> 128 bit multiply, leaving the low half in `a` and the high half in `b`
+static inline void hash_multiply(u64 *const a, u64 *const b) {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 u128;
+    u128 const product = (u128) *a * *b;
+    *a = (u64) product;
+    *b = (u64) (product >> 64u);
+#else
+    u64 const a_lo = *a & 0xffffffffu, a_hi = *a >> 32u;
+    u64 const b_lo = *b & 0xffffffffu, b_hi = *b >> 32u;
+    u64 const lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+    u64 const lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    u64 const cross = (lo_lo >> 32u) + (hi_lo & 0xffffffffu) + lo_hi;
+    *b = hi_hi + (hi_lo >> 32u) + (cross >> 32u);
+    *a = (cross << 32u) | (lo_lo & 0xffffffffu);
+#endif
+}
+
+static inline u64 hash_mix(u64 a, u64 b) {
+    hash_multiply(&a, &b);
+    return a ^ b;
+}
+
+// unaligned little-endian loads (memcpy compiles to a single load)
+static inline u64 hash_read_8(char const *const p) {
+    u64 value;
+    memcpy(&value, p, sizeof value);
+    return value;
+}
+
+static inline u64 hash_read_4(char const *const p) {
+    u32 value;
+    memcpy(&value, p, sizeof value);
+    return value;
+}
+
+// 1 to 3 bytes, read as first, middle and last byte
+static inline u64 hash_read_3(char const *const p, usize const len) {
+    return ((u64) (u8) p[0] << 16u) | ((u64) (u8) p[len >> 1u] << 8u) | (u64) (u8) p[len - 1u];
+}
+
+usize charslice_hash(struct CharSlice const s) {
+    char const *p = s.ptr;
+    usize const len = s.len;
+    u64 seed = hash_mix(hash_secret[0], hash_secret[1]);
+    u64 a, b;
+
+    // inputs of up to 16 bytes are read as (possibly overlapping) words from both ends, so no 
+    // read goes past the slice
+    if (len <= 16u) {
+        if (len >= 4u) {
+            usize const middle = (len >> 3u) << 2u;
+            a = (hash_read_4(p) << 32u) | hash_read_4(p + middle);
+            b = (hash_read_4(p + len - 4u) << 32u) | hash_read_4(p + len - 4u - middle);
+        } else if (len > 0u) {
+            a = hash_read_3(p, len);
+            b = 0u;
+        } else {
+            a = 0u;
+            b = 0u;
+        }
+    } else {
+        usize remaining = len;
+
+        while (remaining > 16u) {
+            seed = hash_mix(hash_read_8(p) ^ hash_secret[1], hash_read_8(p + 8u) ^ seed);
+            p += 16u;
+            remaining -= 16u;
+        }
+
+        // the last 16 bytes, overlapping the previous step if the length is not a multiple of 16
+        a = hash_read_8(p + remaining - 16u);
+        b = hash_read_8(p + remaining - 8u);
     }
 
-    return hash;
+    a ^= hash_secret[1];
+    b ^= seed;
+    hash_multiply(&a, &b);
+    return (usize) hash_mix(a ^ hash_secret[0] ^ (u64) len, b ^ hash_secret[1]);
 }
@@ -0,0 +1,145 @@
+#include "cc/interner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/hash.h"
+#include "cc/log.h"
+
+// define InternerEntrySlice and InternerEntryVec
+#define SLICE_TYPE InternerEntrySlice 
+#define SLICE_ELEMENT_TYPE struct InternerEntry 
+#define SLICE_FUNCTION_PREFIX internerentryslice_
+#include "cc/template/slice.inl"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define VEC_TYPE InternerEntryVec 
+#define VEC_ELEMENT_TYPE struct InternerEntry 
+#define VEC_SLICE_TYPE InternerEntrySlice
+#define VEC_FUNCTION_PREFIX internerentryvec_
+#include "cc/template/vec.inl"
+#undef VEC_ELEMENT_TYPE
+#undef VEC_TYPE
+#undef VEC_SLICE_TYPE
+#undef VEC_FUNCTION_PREFIX
+
+// must be a power of 2
+#define INTERNER_INITIAL_TABLE_SIZE 1024u
+
+// slot for `hash`, either empty or holding the symbol for `name`
+static usize interner_find_slot(
+    struct Interner const *const self, 
+    struct CharSlice const name, 
+    u32 const hash
+) {
+    usize const mask = self->table_size - 1u;
+    usize slot = hash & mask;
+
+    for (;;) {
+        u32 const stored = self->table[slot];
+
+        if (stored == 0u) {
+            return slot;
+        }
+
+        struct InternerEntry const *const entry = &self->entries.data[stored - 1u];
+
+        if (entry->hash == hash 
+            && entry->len == name.len 
+            && memcmp(self->bytes.data + entry->offset, name.ptr, name.len) == 0
+        ) {
+            return slot;
+        }
+
+        // linear probing
+        slot = (slot + 1u) & mask;
+    }
+}
+
+static void interner_grow(struct Interner *const self) {
+    usize const new_table_size = self->table_size * 2u;
+    usize const mask = new_table_size - 1u;
+    u32 *const new_table = calloc(new_table_size, sizeof *new_table);
+
+    // every name is distinct, so reinsertion only needs the stored hash
+    for (usize symbol = 0u; symbol < self->entries.len; symbol += 1u) {
+        usize slot = self->entries.data[symbol].hash & mask;
+
+        while (new_table[slot] != 0u) {
+            slot = (slot + 1u) & mask;
+        }
+
+        new_table[slot] = (u32) symbol + 1u;
+    }
+
+    free(self->table);
+    self->table = new_table;
+    self->table_size = new_table_size;
+}
+
+void interner_init(struct Interner *const self) {
+    charvec_init(&self->bytes);
+    internerentryvec_init(&self->entries);
+    self->table = calloc(INTERNER_INITIAL_TABLE_SIZE, sizeof *self->table);
+    self->table_size = INTERNER_INITIAL_TABLE_SIZE;
+}
+
+void interner_free(struct Interner *const self) {
+    charvec_free(&self->bytes);
+    internerentryvec_free(&self->entries);
+    free(self->table);
+}
+
+u32 interner_intern(struct Interner *const self, struct CharSlice const name) {
+    u32 const hash = (u32) charslice_hash(name);
+    usize const slot = interner_find_slot(self, name, hash);
+
+    if (self->table[slot] != 0u) {
+        return self->table[slot] - 1u;
+    }
+
+    if (self->entries.len >= UINT32_MAX - 1u || name.len > UINT32_MAX) {
+        log_error("interner_intern: too many symbols");
+        exit(1);
+    }
+
+    u32 const symbol = (u32) self->entries.len;
+
+    internerentryvec_push(
+        &self->entries, 
+        (struct InternerEntry) {
+            .offset = self->bytes.len,
+            .len = (u32) name.len,
+            .hash = hash,
+        }
+    );
+    charvec_push_slice(&self->bytes, name);
+
+    self->table[slot] = symbol + 1u;
+
+    // keep the load factor at most 1/2
+    if (self->entries.len * 2u > self->table_size) {
+        interner_grow(self);
+    }
+
+    return symbol;
+}
+
+struct CharSlice interner_name(struct Interner const *const self, u32 const symbol) {
+    struct InternerEntry const *const entry = internerentryvec_at(&self->entries, symbol);
+
+    return (struct CharSlice) {
+        .ptr = self->bytes.data + entry->offset,
+        .len = entry->len,
+    };
+}
+
+struct InternerStatistics interner_statistics(struct Interner const *const self) {
+    return (struct InternerStatistics) {
+        .symbol_count = self->entries.len,
+        .bytes_stored = self->bytes.len,
+        .table_size = self->table_size,
+    };
+}
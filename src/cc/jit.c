@@ -0,0 +1,378 @@
+#include "cc/jit.h"
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cc/common.h"
+#include "cc/compile/encoder.h"
+#include "cc/log.h"
+#include "cc/map.h"
+#include "cc/slice.h"
+#include "cc/writer.h"
+
+#define JIT_TEXT_ALIGN 16u
+#define JIT_IMPORT_TABLE_SIZE 64u
+#define JIT_PATH_LEN 64u
+
+// jmp qword [rip+0], followed by the address to jump to, and padding
+#define JIT_STUB_LEN 16u
+#define JIT_STUB_JUMP_LEN 6u
+static u8 const stub_jump[JIT_STUB_JUMP_LEN] = { 0xffu, 0x25u, 0x00u, 0x00u, 0x00u, 0x00u };
+
+// the generated code uses rbx (and may use r12-r15) as scratch without saving them, which the
+// entry stub of an executable does not mind, but a C caller does; so main is called through this,
+// with its address in rdi:
+//     push rbx; push r12; push r13; push r14; push r15
+//     call rdi
+//     pop r15; pop r14; pop r13; pop r12; pop rbx
+//     ret
+// (five pushes keep the stack 16-byte aligned at the call)
+#define JIT_ENTRY_LEN 21u
+static u8 const entry_trampoline[JIT_ENTRY_LEN] = {
+    0x53u, 0x41u, 0x54u, 0x41u, 0x55u, 0x41u, 0x56u, 0x41u, 0x57u,
+    0xffu, 0xd7u,
+    0x41u, 0x5fu, 0x41u, 0x5eu, 0x41u, 0x5du, 0x41u, 0x5cu, 0x5bu,
+    0xc3u,
+};
+
+static usize page_len(void) {
+    return (usize) sysconf(_SC_PAGESIZE);
+}
+
+static void write_le(char *const bytes, u64 const value, usize const len) {
+    for (usize i = 0u; i < len; i += 1u) {
+        bytes[i] = (char) (u8) (value >> (8u * i));
+    }
+}
+
+// address of `name` among the libraries loaded into the process, NULL if there is none
+static void *resolve_import(void *const handle, struct CharSlice const name) {
+    char *const name_cstr = malloc(name.len + 1u);
+    if (name_cstr == NULL) {
+        log_error("jit_load: cannot allocate symbol name");
+        exit(1);
+    }
+
+    memcpy(name_cstr, name.ptr, name.len);
+    name_cstr[name.len] = '\0';
+
+    void *const address = dlsym(handle, name_cstr);
+    free(name_cstr);
+
+    return address;
+}
+
+bool jit_load(struct JitProgram *const self, struct CodeBuffer const *const text, struct CodeBuffer const *const data) {
+    if (data->fixups.len > 0u) {
+        log_error("jit_load: the data section refers to undefined labels");
+        return false;
+    }
+
+    // one stub for every fixup at most (several calls to one function share its stub)
+    usize const stubs_offset = round_up_usize(text->bytes.len, JIT_TEXT_ALIGN);
+    usize const entry_offset = stubs_offset + text->fixups.len * JIT_STUB_LEN;
+    usize const executable_len = entry_offset + JIT_ENTRY_LEN;
+    usize const data_offset = round_up_usize(executable_len, page_len());
+    usize const len = max_usize(round_up_usize(data_offset + data->bytes.len, page_len()), page_len());
+
+    char *const memory = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        log_error("jit_load: cannot map %zu bytes: %s", len, strerror(errno));
+        exit(1);
+    }
+
+    memcpy(memory, text->bytes.data, text->bytes.len);
+    memcpy(memory + entry_offset, entry_trampoline, JIT_ENTRY_LEN);
+    if (data->bytes.len > 0u) {
+        memcpy(memory + data_offset, data->bytes.data, data->bytes.len);
+    }
+
+    // the process itself, and the libraries it has loaded
+    void *const handle = dlopen(NULL, RTLD_NOW);
+    if (handle == NULL) {
+        log_error("jit_load: cannot open the symbols of the process: %s", dlerror());
+        exit(1);
+    }
+
+    struct Map__CharSlice_usize stubs;
+    map__charslice_usize__init(&stubs, JIT_IMPORT_TABLE_SIZE);
+    usize stub_count = 0u;
+    bool ok = true;
+
+    for (usize i = 0u; i < text->fixups.len && ok; i += 1u) {
+        struct CodeFixup const *const fixup = &text->fixups.data[i];
+
+        usize const *const existing = map__charslice_usize__get(&stubs, fixup->label);
+        usize stub_offset;
+
+        if (existing != NULL) {
+            stub_offset = *existing;
+        } else {
+            void *const address = resolve_import(handle, fixup->label);
+            if (address == NULL) {
+                log_error("jit_load: undefined reference to %.*s", (int) fixup->label.len, fixup->label.ptr);
+                ok = false;
+                break;
+            }
+
+            stub_offset = stubs_offset + stub_count * JIT_STUB_LEN;
+            stub_count += 1u;
+
+            memcpy(memory + stub_offset, stub_jump, JIT_STUB_JUMP_LEN);
+            write_le(memory + stub_offset + JIT_STUB_JUMP_LEN, (u64) (uintptr_t) address, 8u);
+            map__charslice_usize__set(&stubs, fixup->label, stub_offset);
+        }
+
+        // the stubs are in the same mapping, so always within reach
+        i64 const displacement = (i64) stub_offset - (i64) (fixup->offset + 4u);
+        write_le(memory + fixup->offset, (u64) displacement, 4u);
+    }
+
+    map__charslice_usize__free(&stubs);
+    dlclose(handle);
+
+    if (!ok) {
+        munmap(memory, len);
+        return false;
+    }
+
+    if (mprotect(memory, round_up_usize(executable_len, page_len()), PROT_READ | PROT_EXEC) != 0) {
+        log_error("jit_load: cannot make code executable: %s", strerror(errno));
+        exit(1);
+    }
+
+    *self = (struct JitProgram) {
+        .memory = memory,
+        .len = len,
+        .text_len = text->bytes.len,
+        .entry_offset = entry_offset,
+        .executable_len = executable_len,
+        .text = text,
+        .jitdump_mapping = NULL,
+        .jitdump_mapping_len = 0u,
+    };
+
+    return true;
+}
+
+void jit_free(struct JitProgram *const self) {
+    if (self->jitdump_mapping != NULL) {
+        munmap(self->jitdump_mapping, self->jitdump_mapping_len);
+    }
+
+    munmap(self->memory, self->len);
+}
+
+void const *jit_symbol(struct JitProgram const *const self, struct CharSlice const name) {
+    usize const *const offset = map__charslice_usize__get(&self->text->label_offsets, name);
+
+    return offset == NULL ? NULL : self->memory + *offset;
+}
+
+i32 jit_call_main(struct JitProgram const *const self) {
+    void const *const address = jit_symbol(self, charslice_from_cstr("main"));
+    if (address == NULL) {
+        log_error("jit_call_main: there is no main function");
+        exit(1);
+    }
+
+    // ISO C has no conversion from object to function pointers
+    char const *const entry_address = self->memory + self->entry_offset;
+    i32 (*entry)(void const *function);
+    memcpy(&entry, &entry_address, sizeof (entry));
+
+    return entry(address);
+}
+
+// size of the function at label `index`: up to the next label, or the end of the text
+static usize label_len(struct JitProgram const *const self, usize const index) {
+    struct CodeLabelVec const *const labels = &self->text->labels;
+    usize const end = index + 1u < labels->len ? labels->data[index + 1u].offset : self->text_len;
+
+    return end - labels->data[index].offset;
+}
+
+bool jit_write_perf_map(struct JitProgram const *const self) {
+    char path[JIT_PATH_LEN];
+    snprintf(path, sizeof (path), "/tmp/perf-%d.map", (i32) getpid());
+
+    FILE *const file = fopen(path, "w");
+    if (file == NULL) {
+        log_error("jit_write_perf_map: could not open %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    // START SIZE symbolname, in hex
+    struct Writer writer = file_writer(file);
+    struct CodeLabelVec const *const labels = &self->text->labels;
+
+    for (usize i = 0u; i < labels->len; i += 1u) {
+        writer_writef(
+            &writer,
+            "%lx %zx %.*s\n",
+            (u64) (uintptr_t) (self->memory + labels->data[i].offset),
+            label_len(self, i),
+            (int) labels->data[i].name.len,
+            labels->data[i].name.ptr
+        );
+    }
+
+    usize const stubs_offset = round_up_usize(self->text_len, JIT_TEXT_ALIGN);
+    if (self->entry_offset > stubs_offset) {
+        writer_writef(
+            &writer,
+            "%lx %zx [jit stubs]\n",
+            (u64) (uintptr_t) (self->memory + stubs_offset),
+            self->entry_offset - stubs_offset
+        );
+    }
+    writer_writef(
+        &writer,
+        "%lx %zx [jit entry]\n",
+        (u64) (uintptr_t) (self->memory + self->entry_offset),
+        self->executable_len - self->entry_offset
+    );
+
+    writer_free(&writer);
+
+    if (ferror(file) != 0 || fclose(file) != 0) {
+        log_error("jit_write_perf_map: could not write %s", path);
+        return false;
+    }
+
+    return true;
+}
+
+// jitdump format (see tools/perf/Documentation/jitdump-specification.txt in the Linux sources)
+
+#define JITDUMP_MAGIC 0x4a695444u
+#define JITDUMP_VERSION 1u
+#define JITDUMP_CODE_LOAD 0u
+
+struct JitdumpHeader {
+    u32 magic;
+    u32 version;
+    u32 total_size;
+    u32 elf_mach;
+    u32 pad1;
+    u32 pid;
+    u64 timestamp;
+    u64 flags;
+};
+
+struct JitdumpRecordHeader {
+    u32 id;
+    u32 total_size;
+    u64 timestamp;
+};
+
+// followed by the null-terminated function name, then its code
+struct JitdumpCodeLoad {
+    struct JitdumpRecordHeader header;
+    u32 pid;
+    u32 tid;
+    u64 vma;
+    u64 code_addr;
+    u64 code_size;
+    u64 code_index;
+};
+
+// perf matches the timestamps with its own clock (`perf record -k mono`)
+static u64 jitdump_timestamp(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (u64) now.tv_sec * 1000000000u + (u64) now.tv_nsec;
+}
+
+bool jit_write_jitdump(struct JitProgram *const self) {
+    char path[JIT_PATH_LEN];
+    snprintf(path, sizeof (path), "/tmp/jit-%d.dump", (i32) getpid());
+
+    i32 const fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd < 0) {
+        log_error("jit_write_jitdump: could not open %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    FILE *const file = fdopen(fd, "w");
+    if (file == NULL) {
+        log_error("jit_write_jitdump: could not open %s: %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    // the process is single-threaded, so its thread id is its process id
+    u32 const pid = (u32) getpid();
+
+    struct Writer writer = file_writer(file);
+
+    struct JitdumpHeader const header = {
+        .magic = JITDUMP_MAGIC,
+        .version = JITDUMP_VERSION,
+        .total_size = sizeof (struct JitdumpHeader),
+        .elf_mach = EM_X86_64,
+        .pad1 = 0u,
+        .pid = pid,
+        .timestamp = jitdump_timestamp(),
+        .flags = 0u,
+    };
+    writer_write_bytes(&writer, (char const *) &header, sizeof (header));
+    writer_flush(&writer);
+
+    // perf finds the file through this (executable) mapping of it in the recording
+    self->jitdump_mapping_len = page_len();
+    self->jitdump_mapping = mmap(NULL, self->jitdump_mapping_len, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+    if (self->jitdump_mapping == MAP_FAILED) {
+        log_error("jit_write_jitdump: could not map %s: %s", path, strerror(errno));
+        self->jitdump_mapping = NULL;
+        writer_free(&writer);
+        fclose(file);
+        return false;
+    }
+
+    struct CodeLabelVec const *const labels = &self->text->labels;
+
+    for (usize i = 0u; i < labels->len; i += 1u) {
+        struct CodeLabel const *const label = &labels->data[i];
+        usize const code_len = label_len(self, i);
+        u64 const address = (u64) (uintptr_t) (self->memory + label->offset);
+
+        struct JitdumpCodeLoad const record = {
+            .header = {
+                .id = JITDUMP_CODE_LOAD,
+                .total_size = (u32) (sizeof (struct JitdumpCodeLoad) + label->name.len + 1u + code_len),
+                .timestamp = jitdump_timestamp(),
+            },
+            .pid = pid,
+            .tid = pid,
+            .vma = address,
+            .code_addr = address,
+            .code_size = code_len,
+            .code_index = i,
+        };
+
+        writer_write_bytes(&writer, (char const *) &record, sizeof (record));
+        writer_write_charslice(&writer, label->name);
+        writer_write_char(&writer, '\0');
+        writer_write_bytes(&writer, self->memory + label->offset, code_len);
+    }
+
+    writer_free(&writer);
+
+    if (ferror(file) != 0 || fclose(file) != 0) {
+        log_error("jit_write_jitdump: could not write %s", path);
+        return false;
+    }
+
+    return true;
+}
@@ -1,33 +1,114 @@
 #include "cc/lexer.h"
 
-#include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "cc/char_class.h"
 #include "cc/log.h"
 #include "cc/slice.h"
 #include "cc/token.h"
+#include "cc/token_store.h"
 
-struct Lexer {
-    char const *source_string;
+// Keywords are recognized with a perfect hash of (length, first character, last character) 
+// followed by a single comparison. The hash multiplier is searched for the first time a lexer 
+// is created, so the table stays collision-free as keywords are added to TokenKind
 
-    usize character_index;
-    usize line_index;
-    usize line_start_index;
+// must be a power of 2
+#define KEYWORD_TABLE_SIZE 64u
+#define KEYWORD_TABLE_BITS 6u
+#define KEYWORD_HASH_MAX_ATTEMPTS 100000u
+
+struct KeywordTableEntry {
+    char const *name; // NULL for empty slots
+    usize len;
+    enum TokenKind kind;
 };
 
-static bool is_whitespace(char const c) {
-    return c == ' '
-        || c == '\t'
-        || c == '\n'
-        || c == '\r';
+static struct {
+    bool initialized;
+    u32 multiplier;
+    struct KeywordTableEntry entries[KEYWORD_TABLE_SIZE];
+} keyword_table;
+
+static usize keyword_hash(u32 const multiplier, struct CharSlice const word) {
+    u32 const key = (u32) word.len
+        | (u32) (u8) word.ptr[0] << 8u
+        | (u32) (u8) word.ptr[word.len - 1u] << 16u;
+
+    return (usize) ((key * multiplier) >> (32u - KEYWORD_TABLE_BITS));
 }
 
-static bool is_letter_or_underscore(char const c) {
-    return isalpha(c) || c == '_';
+// try to place every keyword using `multiplier`, returns false on a collision
+static bool keyword_table_try_build(u32 const multiplier) {
+    memset(keyword_table.entries, 0, sizeof keyword_table.entries);
+
+    for (usize kind = 0u; kind < TokenCount; kind += 1u) {
+        char const *const name = token_kind_name((enum TokenKind) kind);
+
+        if (!char_has_class(name[0], CharClassLetter)) {
+            // punctuation or a variable token
+            continue;
+        }
+
+        struct CharSlice const word = charslice_from_cstr(name);
+        struct KeywordTableEntry *const entry 
+            = &keyword_table.entries[keyword_hash(multiplier, word)];
+
+        if (entry->name != NULL) {
+            return false;
+        }
+
+        *entry = (struct KeywordTableEntry) {
+            .name = name,
+            .len = word.len,
+            .kind = (enum TokenKind) kind,
+        };
+    }
+
+    return true;
 }
 
-static bool is_letter_underscore_or_digit(char const c) {
-    return is_letter_or_underscore(c) || isdigit(c);
+static void keyword_table_init(void) {
+    if (keyword_table.initialized) {
+        return;
+    }
+
+    // keywords are told apart from punctuation by their character class
+    char_class_init();
+
+    u32 multiplier = 0x9e3779b1u;
+
+    for (usize attempt = 0u; attempt < KEYWORD_HASH_MAX_ATTEMPTS; attempt += 1u) {
+        if (keyword_table_try_build(multiplier)) {
+            keyword_table.initialized = true;
+            keyword_table.multiplier = multiplier;
+            return;
+        }
+
+        // next odd multiplier
+        multiplier += 2u;
+    }
+
+    log_error("keyword_table_init: no perfect hash found, increase KEYWORD_TABLE_SIZE");
+    exit(1);
+}
+
+// returns the keyword token for `word`, or TokenIdentifier if it is not a keyword
+static enum TokenKind keyword_lookup(struct CharSlice const word) {
+    struct KeywordTableEntry const *const entry 
+        = &keyword_table.entries[keyword_hash(keyword_table.multiplier, word)];
+
+    if (entry->len == word.len && memcmp(entry->name, word.ptr, word.len) == 0) {
+        return entry->kind;
+    } else {
+        return TokenIdentifier;
+    }
+}
+
+enum TokenKind lexer_keyword_kind(struct CharSlice const word) {
+    keyword_table_init();
+
+    return keyword_lookup(word);
 }
 
 static bool parse_integer_literal(
@@ -113,23 +194,24 @@ static bool parse_integer_literal(
     return char_index == word.len;
 }
 
-static void lexer_init(struct Lexer *const self, char const *const source_string) {
+void lexer_init(
+    struct Lexer *const self, 
+    char const *const source_string, 
+    u32 const file,
+    struct Interner *const interner
+) {
+    char_class_init();
+    keyword_table_init();
+
     self->source_string = source_string;
+    self->file = file;
+    self->interner = interner;
     self->character_index = 0u;
-    self->line_index = 1u;
-    self->line_start_index = 0u;
 }
 
 static char lexer_next_char(struct Lexer *const self) {
     char const c = self->source_string[self->character_index];
     self->character_index += 1;
-
-    // update line count
-    if (c == '\n') {
-        self->line_index += 1;
-        self->line_start_index = self->character_index;
-    }
-
     return c;
 }
 
@@ -138,35 +220,30 @@ static char lexer_peek_char(struct Lexer *const self) {
 }
 
 static void lexer_skip_whitespace(struct Lexer *const self) {
-    while (is_whitespace(lexer_peek_char(self))) {
-        lexer_next_char(self);
-    }
+    self->character_index += scan_whitespace(self->source_string + self->character_index);
 }
 
 static struct CharSlice lexer_next_word(struct Lexer *const self) {
     char const *const ptr = self->source_string + self->character_index;
 
-    usize len = 0;
-    while (is_letter_underscore_or_digit(lexer_peek_char(self))) {
-        len++;
-        lexer_next_char(self);
-    }
+    usize const len = scan_word(ptr);
+    self->character_index += len;
 
     return (struct CharSlice) { (char *) ptr, len };
 }
 
-static struct Token lexer_next_token(struct Lexer *const self) {
+struct Token lexer_next_token(struct Lexer *const self) {
     lexer_skip_whitespace(self);
 
-    char const c = lexer_next_char(self);
-
     struct Token token = (struct Token) {
         .position = (struct TokenPosition) {
-            .line = self->line_index,
-            .character = self->character_index - self->line_start_index,
+            .file = self->file,
+            .offset = (u32) self->character_index,
         }
     };
 
+    char const c = lexer_next_char(self);
+
     switch (c) {
         case '\0': {
             token.kind = TokenEof;
@@ -234,7 +311,7 @@ static struct Token lexer_next_token(struct Lexer *const self) {
             break;
         }
         default: {
-            if (isdigit(c)) {
+            if (char_has_class(c, CharClassDigit)) {
                 // number
                 self->character_index -= 1;
                 struct CharSlice const word = lexer_next_word(self);
@@ -251,50 +328,16 @@ static struct Token lexer_next_token(struct Lexer *const self) {
                 } else {
                     token.kind = TokenUnknown;
                 }
-            } else if (is_letter_or_underscore(c)) {
+            } else if (char_has_class(c, CharClassLetter)) {
                 // word
                 self->character_index -= 1;
                 struct CharSlice const word = lexer_next_word(self);
 
-                if (charslice_eq_cstr(word, "return")) {
-                    token.kind = TokenKeywordReturn;
-                } else if (charslice_eq_cstr(word, "if")) {
-                    token.kind = TokenKeywordIf;
-                } else if (charslice_eq_cstr(word, "do")) {
-                    token.kind = TokenKeywordDo;
-                } else if (charslice_eq_cstr(word, "while")) {
-                    token.kind = TokenKeywordWhile;
-                } else if (charslice_eq_cstr(word, "for")) {
-                    token.kind = TokenKeywordFor;
-                } else if (charslice_eq_cstr(word, "switch")) {
-                    token.kind = TokenKeywordSwitch;
-                } else if (charslice_eq_cstr(word, "continue")) {
-                    token.kind = TokenKeywordContinue;
-                } else if (charslice_eq_cstr(word, "break")) {
-                    token.kind = TokenKeywordBreak;
-                } else if (charslice_eq_cstr(word, "const")) {
-                    token.kind = TokenKeywordConst;
-                } else if (charslice_eq_cstr(word, "void")) {
-                    token.kind = TokenKeywordVoid;
-                } else if (charslice_eq_cstr(word, "int")) {
-                    token.kind = TokenKeywordInt;
-                } else if (charslice_eq_cstr(word, "signed")) {
-                    token.kind = TokenKeywordSigned;
-                } else if (charslice_eq_cstr(word, "unsigned")) {
-                    token.kind = TokenKeywordUnsigned;
-                } else if (charslice_eq_cstr(word, "long")) {
-                    token.kind = TokenKeywordLong;
-                } else if (charslice_eq_cstr(word, "short")) {
-                    token.kind = TokenKeywordShort;
-                } else if (charslice_eq_cstr(word, "char")) {
-                    token.kind = TokenKeywordChar;
-                } else if (charslice_eq_cstr(word, "float")) {
-                    token.kind = TokenKeywordFloat;
-                } else if (charslice_eq_cstr(word, "double")) {
-                    token.kind = TokenKeywordDouble;
-                } else {
-                    token.kind = TokenIdentifier;
+                token.kind = keyword_lookup(word);
+
+                if (token.kind == TokenIdentifier) {
                     token.variant.identifier.name = word;
+                    token.variant.identifier.symbol = interner_intern(self->interner, word);
                 }
             } else {
                 token.kind = TokenUnknown;
@@ -305,19 +348,19 @@ static struct Token lexer_next_token(struct Lexer *const self) {
     return token;
 }
 
-struct TokenVec tokenize(char const *const source_string) {
+void tokenize(
+    struct TokenStore *const out,
+    char const *const source_string, 
+    u32 const file,
+    struct Interner *const interner
+) {
     struct Lexer lexer;
-    lexer_init(&lexer, source_string);
-
-    struct TokenVec tokens;
-    tokenvec_init(&tokens);
+    lexer_init(&lexer, source_string, file, interner);
+    token_store_init(out, source_string, file, interner);
 
     struct Token token;
     do {
         token = lexer_next_token(&lexer);
-        tokenvec_push(&tokens, token);
+        token_store_push(out, &token);
     } while (token.kind != TokenEof);
-
-    return tokens;
 }
-
@@ -0,0 +1,605 @@
+#include "cc/linker.h"
+
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/common.h"
+#include "cc/compile/encoder.h"
+#include "cc/elf_object.h"
+#include "cc/log.h"
+#include "cc/map.h"
+#include "cc/slice.h"
+#include "cc/writer.h"
+
+// Layout of the executable, each segment starting on its own page (at the address given by its
+// file offset, so the file maps straight into memory):
+//  - read-only: headers, then for dynamic programs the interpreter path, dynamic symbols and
+//    strings, symbol hash table and GOT relocations, then read-only data
+//  - executable: entry point, PLT, then the text of every unit
+//  - writable: for dynamic programs the dynamic section and GOT, then data, then bss
+// Calls to the library go through a PLT entry that jumps through the GOT entry of the function,
+// which the dynamic linker fills in before the program starts (the program is bound now, not
+// lazily, so there is no resolver stub)
+
+#define LINK_BASE_ADDRESS 0x400000u
+#define LINK_PAGE_LEN 0x1000u
+#define LINK_TEXT_ALIGN 16u
+#define LINK_DATA_ALIGN 8u
+#define LINK_PLT_ENTRY_LEN 8u
+#define LINK_SYMBOL_TABLE_SIZE 64u
+
+#define LINK_PROGRAM_HEADER_MAX_COUNT 7u
+#define LINK_DYNAMIC_ENTRY_COUNT 12u
+
+// xor ebp, ebp; and rsp, -16; call main; mov edi, eax; mov eax, 60 (exit); syscall
+static u8 const static_entry[] = {
+    0x31u, 0xedu,
+    0x48u, 0x83u, 0xe4u, 0xf0u,
+    0xe8u, 0x00u, 0x00u, 0x00u, 0x00u,
+    0x89u, 0xc7u,
+    0xb8u, 0x3cu, 0x00u, 0x00u, 0x00u,
+    0x0fu, 0x05u,
+};
+
+// xor ebp, ebp; and rsp, -16; call main; mov edi, eax; call exit; hlt
+static u8 const dynamic_entry[] = {
+    0x31u, 0xedu,
+    0x48u, 0x83u, 0xe4u, 0xf0u,
+    0xe8u, 0x00u, 0x00u, 0x00u, 0x00u,
+    0x89u, 0xc7u,
+    0xe8u, 0x00u, 0x00u, 0x00u, 0x00u,
+    0xf4u,
+};
+
+// offsets of the rel32 fields of the calls in the entry points
+#define ENTRY_CALL_MAIN_OFFSET 7u
+#define ENTRY_CALL_EXIT_OFFSET 14u
+
+// offsets of the sections of one unit in the merged sections
+struct LinkUnitLayout {
+    usize text_offset;
+    usize data_offset;
+    usize rodata_offset;
+};
+
+static usize code_len(struct CodeBuffer const *const code) {
+    return code == NULL ? 0u : code->bytes.len;
+}
+
+static void image_write_le(char *const image, usize const offset, u64 const value, usize const len) {
+    for (usize i = 0u; i < len; i += 1u) {
+        image[offset + i] = (char) (u8) (value >> (8u * i));
+    }
+}
+
+// fills in the rel32 field at `offset` of the image (at `field_address` in memory) to refer to
+// `target_address`
+static void image_write_rel32(
+    char *const image,
+    usize const offset,
+    u64 const field_address,
+    u64 const target_address
+) {
+    i64 const displacement = (i64) target_address - (i64) (field_address + 4u);
+
+    if (displacement < INT32_MIN || displacement > INT32_MAX) {
+        log_error("link_executable: call displacement %ld does not fit in 32 bits", displacement);
+        exit(1);
+    }
+
+    image_write_le(image, offset, (u64) displacement, 4u);
+}
+
+static void image_write_bytes(char *const image, usize const offset, char const *const bytes, usize const len) {
+    if (len > 0u) {
+        memcpy(image + offset, bytes, len);
+    }
+}
+
+// symbols of the units being linked
+struct LinkSymbols {
+    // address of every label of the units (0 until they are laid out)
+    struct Map__CharSlice_usize definitions;
+    // index of every function imported from the library, in `import_names`
+    struct Map__CharSlice_usize imports;
+    struct CharSlice *import_names;
+    usize import_count;
+};
+
+static void link_symbols_init(struct LinkSymbols *const self, usize const import_capacity) {
+    map__charslice_usize__init(&self->definitions, LINK_SYMBOL_TABLE_SIZE);
+    map__charslice_usize__init(&self->imports, LINK_SYMBOL_TABLE_SIZE);
+    self->import_names = calloc(max_usize(import_capacity, 1u), sizeof (struct CharSlice));
+    self->import_count = 0u;
+
+    if (self->import_names == NULL) {
+        log_error("link_executable: cannot allocate symbol tables");
+        exit(1);
+    }
+}
+
+static void link_symbols_free(struct LinkSymbols *const self) {
+    map__charslice_usize__free(&self->definitions);
+    map__charslice_usize__free(&self->imports);
+    free(self->import_names);
+}
+
+static void link_symbols_import(struct LinkSymbols *const self, struct CharSlice const name) {
+    if (!map__charslice_usize__contains_key(&self->imports, name)) {
+        map__charslice_usize__set(&self->imports, name, self->import_count);
+        self->import_names[self->import_count] = name;
+        self->import_count += 1u;
+    }
+}
+
+static usize link_symbols_import_index(struct LinkSymbols const *const self, struct CharSlice const name) {
+    return *map__charslice_usize__get(&self->imports, name);
+}
+
+// records the labels of `code` as defined, with a placeholder address
+static bool link_symbols_define(struct LinkSymbols *const self, struct CodeBuffer const *const code) {
+    if (code == NULL) {
+        return true;
+    }
+
+    for (usize i = 0u; i < code->labels.len; i += 1u) {
+        struct CharSlice const name = code->labels.data[i].name;
+
+        if (map__charslice_usize__contains_key(&self->definitions, name)) {
+            log_error("link_executable: multiple definitions of %.*s", (int) name.len, name.ptr);
+            return false;
+        }
+        map__charslice_usize__set(&self->definitions, name, 0u);
+    }
+
+    return true;
+}
+
+static void link_symbols_set_addresses(
+    struct LinkSymbols *const self,
+    struct CodeBuffer const *const code,
+    u64 const address
+) {
+    if (code == NULL) {
+        return;
+    }
+
+    for (usize i = 0u; i < code->labels.len; i += 1u) {
+        struct CodeLabel const *const label = &code->labels.data[i];
+        map__charslice_usize__set(&self->definitions, label->name, address + label->offset);
+    }
+}
+
+// finds the definition of every label, and which functions have to come from the library
+// (which makes the program dynamic)
+static bool link_symbols_resolve(
+    struct LinkSymbols *const self,
+    struct ObjectSections const *const units,
+    usize const unit_count,
+    enum LinkMode const mode,
+    bool *const is_dynamic_out
+) {
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        bool const defined = link_symbols_define(self, units[unit].text)
+            && link_symbols_define(self, units[unit].data)
+            && link_symbols_define(self, units[unit].rodata);
+        if (!defined) {
+            return false;
+        }
+    }
+
+    if (!map__charslice_usize__contains_key(&self->definitions, charslice_from_cstr("main"))) {
+        log_error("link_executable: undefined reference to main");
+        return false;
+    }
+
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        struct CodeFixupVec const *const fixups = &units[unit].text->fixups;
+
+        for (usize i = 0u; i < fixups->len; i += 1u) {
+            if (!map__charslice_usize__contains_key(&self->definitions, fixups->data[i].label)) {
+                link_symbols_import(self, fixups->data[i].label);
+            }
+        }
+    }
+
+    bool const is_dynamic = mode == LinkDynamic || (mode == LinkAuto && self->import_count > 0u);
+
+    if (!is_dynamic && self->import_count > 0u) {
+        for (usize i = 0u; i < self->import_count; i += 1u) {
+            log_error(
+                "link_executable: undefined reference to %.*s",
+                (int) self->import_names[i].len,
+                self->import_names[i].ptr
+            );
+        }
+        return false;
+    }
+
+    // the entry point exits through the library
+    if (is_dynamic) {
+        link_symbols_import(self, charslice_from_cstr("exit"));
+    }
+
+    *is_dynamic_out = is_dynamic;
+    return true;
+}
+
+bool link_executable(
+    struct Writer *const writer,
+    struct ObjectSections const *const units,
+    usize const unit_count,
+    enum LinkMode const mode,
+    struct LinkStatistics *const statistics_out
+) {
+    // every fixup may name a different function, and the entry point may need exit
+    usize import_capacity = 1u;
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        import_capacity += units[unit].text->fixups.len;
+    }
+
+    struct LinkSymbols symbols;
+    link_symbols_init(&symbols, import_capacity);
+
+    bool is_dynamic;
+    if (!link_symbols_resolve(&symbols, units, unit_count, mode, &is_dynamic)) {
+        link_symbols_free(&symbols);
+        return false;
+    }
+
+    usize const import_count = symbols.import_count;
+    struct CharSlice const exit_name = charslice_from_cstr("exit");
+
+    struct LinkUnitLayout *const layouts = calloc(max_usize(unit_count, 1u), sizeof (struct LinkUnitLayout));
+    if (layouts == NULL) {
+        log_error("link_executable: cannot allocate unit layouts");
+        exit(1);
+    }
+
+    // merged sections
+
+    u8 const *const entry = is_dynamic ? dynamic_entry : static_entry;
+    usize const entry_len = is_dynamic ? sizeof (dynamic_entry) : sizeof (static_entry);
+
+    usize const plt_offset = round_up_usize(entry_len, LINK_PLT_ENTRY_LEN);
+    usize text_len = plt_offset + import_count * LINK_PLT_ENTRY_LEN;
+    usize data_len = 0u;
+    usize rodata_len = 0u;
+    usize bss_len = 0u;
+
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        text_len = round_up_usize(text_len, LINK_TEXT_ALIGN);
+        layouts[unit].text_offset = text_len;
+        text_len += units[unit].text->bytes.len;
+
+        data_len = round_up_usize(data_len, LINK_DATA_ALIGN);
+        layouts[unit].data_offset = data_len;
+        data_len += code_len(units[unit].data);
+
+        rodata_len = round_up_usize(rodata_len, LINK_DATA_ALIGN);
+        layouts[unit].rodata_offset = rodata_len;
+        rodata_len += code_len(units[unit].rodata);
+
+        // nothing refers to bss yet (there are no labels for it), so only its size matters
+        bss_len = round_up_usize(bss_len, LINK_DATA_ALIGN);
+        bss_len += units[unit].bss_len;
+    }
+
+    // dynamic linking tables
+
+    usize dynstr_len = 0u;
+    usize library_name_offset = 0u;
+    if (is_dynamic) {
+        // leading null, library name, then function names
+        dynstr_len = 1u;
+        library_name_offset = dynstr_len;
+        dynstr_len += strlen(LINK_LIBRARY) + 1u;
+
+        for (usize i = 0u; i < import_count; i += 1u) {
+            dynstr_len += symbols.import_names[i].len + 1u;
+        }
+    }
+
+    usize const dynsym_count = is_dynamic ? import_count + 1u : 0u;
+    usize const interp_len = is_dynamic ? strlen(LINK_INTERPRETER) + 1u : 0u;
+    // nbucket, nchain, one bucket, then one chain entry per symbol
+    usize const hash_len = is_dynamic ? (3u + dynsym_count) * sizeof (u32) : 0u;
+    usize const rela_len = is_dynamic ? import_count * sizeof (Elf64_Rela) : 0u;
+    usize const dynamic_len = is_dynamic ? LINK_DYNAMIC_ENTRY_COUNT * sizeof (Elf64_Dyn) : 0u;
+    usize const got_len = is_dynamic ? import_count * sizeof (u64) : 0u;
+
+    // program headers: PHDR, INTERP, LOAD x3, DYNAMIC, GNU_STACK for dynamic programs, and
+    // LOAD x3, GNU_STACK otherwise
+    usize const program_header_count = is_dynamic ? 7u : 4u;
+
+    // file layout
+
+    usize offset = sizeof (Elf64_Ehdr) + program_header_count * sizeof (Elf64_Phdr);
+
+    usize const interp_offset = offset;
+    offset += interp_len;
+    offset = round_up_usize(offset, 8u);
+    usize const dynsym_offset = offset;
+    offset += dynsym_count * sizeof (Elf64_Sym);
+    usize const dynstr_offset = offset;
+    offset += dynstr_len;
+    offset = round_up_usize(offset, 8u);
+    usize const hash_offset = offset;
+    offset += hash_len;
+    offset = round_up_usize(offset, 8u);
+    usize const rela_offset = offset;
+    offset += rela_len;
+    offset = round_up_usize(offset, LINK_DATA_ALIGN);
+    usize const rodata_offset = offset;
+    offset += rodata_len;
+    usize const read_only_end = offset;
+
+    offset = round_up_usize(offset, LINK_PAGE_LEN);
+    usize const text_offset = offset;
+    offset += text_len;
+    usize const text_end = offset;
+
+    offset = round_up_usize(offset, LINK_PAGE_LEN);
+    usize const writable_offset = offset;
+    usize const dynamic_offset = offset;
+    offset += dynamic_len;
+    usize const got_offset = offset;
+    offset += got_len;
+    offset = round_up_usize(offset, LINK_DATA_ALIGN);
+    usize const data_offset = offset;
+    offset += data_len;
+    usize const file_len = offset;
+    usize const writable_end = round_up_usize(file_len, LINK_DATA_ALIGN) + bss_len;
+
+    u64 const text_address = LINK_BASE_ADDRESS + text_offset;
+    u64 const plt_address = text_address + plt_offset;
+    u64 const got_address = LINK_BASE_ADDRESS + got_offset;
+
+    // symbol addresses
+
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        link_symbols_set_addresses(&symbols, units[unit].text, text_address + layouts[unit].text_offset);
+        link_symbols_set_addresses(&symbols, units[unit].data, LINK_BASE_ADDRESS + data_offset + layouts[unit].data_offset);
+        link_symbols_set_addresses(&symbols, units[unit].rodata, LINK_BASE_ADDRESS + rodata_offset + layouts[unit].rodata_offset);
+    }
+
+    char *const image = calloc(file_len, 1u);
+    if (image == NULL) {
+        log_error("link_executable: cannot allocate %zu bytes for the executable", file_len);
+        exit(1);
+    }
+
+    // text, with every call relocated
+
+    image_write_bytes(image, text_offset, (char const *) entry, entry_len);
+
+    u64 const main_address = *map__charslice_usize__get(&symbols.definitions, charslice_from_cstr("main"));
+    image_write_rel32(image, text_offset + ENTRY_CALL_MAIN_OFFSET, text_address + ENTRY_CALL_MAIN_OFFSET, main_address);
+    if (is_dynamic) {
+        u64 const exit_address = plt_address + link_symbols_import_index(&symbols, exit_name) * LINK_PLT_ENTRY_LEN;
+        image_write_rel32(image, text_offset + ENTRY_CALL_EXIT_OFFSET, text_address + ENTRY_CALL_EXIT_OFFSET, exit_address);
+    }
+
+    for (usize i = 0u; i < import_count; i += 1u) {
+        // jmp qword [rip+disp32] through the GOT entry, padded with a 2-byte nop
+        usize const entry_offset = text_offset + plt_offset + i * LINK_PLT_ENTRY_LEN;
+        u64 const entry_address = plt_address + i * LINK_PLT_ENTRY_LEN;
+
+        image[entry_offset] = (char) 0xffu;
+        image[entry_offset + 1u] = (char) 0x25u;
+        image_write_rel32(image, entry_offset + 2u, entry_address + 2u, got_address + i * sizeof (u64));
+        image[entry_offset + 6u] = (char) 0x66u;
+        image[entry_offset + 7u] = (char) 0x90u;
+    }
+
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        struct CodeBuffer const *const text = units[unit].text;
+        usize const unit_offset = text_offset + layouts[unit].text_offset;
+        u64 const unit_address = text_address + layouts[unit].text_offset;
+
+        image_write_bytes(image, unit_offset, text->bytes.data, text->bytes.len);
+
+        for (usize i = 0u; i < text->fixups.len; i += 1u) {
+            struct CodeFixup const *const fixup = &text->fixups.data[i];
+
+            usize const *const definition = map__charslice_usize__get(&symbols.definitions, fixup->label);
+            u64 const target_address = definition != NULL
+                ? *definition
+                : plt_address + link_symbols_import_index(&symbols, fixup->label) * LINK_PLT_ENTRY_LEN;
+
+            image_write_rel32(image, unit_offset + fixup->offset, unit_address + fixup->offset, target_address);
+        }
+    }
+
+    // data
+
+    for (usize unit = 0u; unit < unit_count; unit += 1u) {
+        if (units[unit].data != NULL) {
+            image_write_bytes(image, data_offset + layouts[unit].data_offset, units[unit].data->bytes.data, units[unit].data->bytes.len);
+        }
+        if (units[unit].rodata != NULL) {
+            image_write_bytes(image, rodata_offset + layouts[unit].rodata_offset, units[unit].rodata->bytes.data, units[unit].rodata->bytes.len);
+        }
+    }
+
+    // dynamic linking tables
+
+    if (is_dynamic) {
+        image_write_bytes(image, interp_offset, LINK_INTERPRETER, interp_len);
+
+        usize string_offset = 0u;
+        image[dynstr_offset] = '\0';
+        string_offset += 1u;
+        image_write_bytes(image, dynstr_offset + string_offset, LINK_LIBRARY, strlen(LINK_LIBRARY) + 1u);
+        string_offset += strlen(LINK_LIBRARY) + 1u;
+
+        Elf64_Sym *const dynsym = (Elf64_Sym *) (image + dynsym_offset);
+        Elf64_Rela *const rela = (Elf64_Rela *) (image + rela_offset);
+
+        for (usize i = 0u; i < import_count; i += 1u) {
+            dynsym[i + 1u] = (Elf64_Sym) {
+                .st_name = (u32) string_offset,
+                .st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+                .st_shndx = SHN_UNDEF,
+            };
+
+            image_write_bytes(image, dynstr_offset + string_offset, symbols.import_names[i].ptr, symbols.import_names[i].len);
+            string_offset += symbols.import_names[i].len + 1u;
+
+            rela[i] = (Elf64_Rela) {
+                .r_offset = got_address + i * sizeof (u64),
+                .r_info = ELF64_R_INFO(i + 1u, R_X86_64_GLOB_DAT),
+                .r_addend = 0,
+            };
+        }
+
+        // a single bucket chaining every symbol: nothing looks symbols up in the executable
+        u32 *const hash = (u32 *) (image + hash_offset);
+        hash[0] = 1u;
+        hash[1] = (u32) dynsym_count;
+        hash[2] = (u32) (dynsym_count - 1u);
+        for (usize i = 0u; i < dynsym_count; i += 1u) {
+            hash[3u + i] = i == 0u ? 0u : (u32) (i - 1u);
+        }
+
+        Elf64_Dyn const dynamic[LINK_DYNAMIC_ENTRY_COUNT] = {
+            { .d_tag = DT_NEEDED,  .d_un.d_val = library_name_offset },
+            { .d_tag = DT_HASH,    .d_un.d_ptr = LINK_BASE_ADDRESS + hash_offset },
+            { .d_tag = DT_STRTAB,  .d_un.d_ptr = LINK_BASE_ADDRESS + dynstr_offset },
+            { .d_tag = DT_SYMTAB,  .d_un.d_ptr = LINK_BASE_ADDRESS + dynsym_offset },
+            { .d_tag = DT_STRSZ,   .d_un.d_val = dynstr_len },
+            { .d_tag = DT_SYMENT,  .d_un.d_val = sizeof (Elf64_Sym) },
+            { .d_tag = DT_RELA,    .d_un.d_ptr = LINK_BASE_ADDRESS + rela_offset },
+            { .d_tag = DT_RELASZ,  .d_un.d_val = rela_len },
+            { .d_tag = DT_RELAENT, .d_un.d_val = sizeof (Elf64_Rela) },
+            { .d_tag = DT_FLAGS,   .d_un.d_val = DF_BIND_NOW },
+            { .d_tag = DT_DEBUG,   .d_un.d_val = 0u },
+            { .d_tag = DT_NULL,    .d_un.d_val = 0u },
+        };
+        memcpy(image + dynamic_offset, dynamic, sizeof (dynamic));
+    }
+
+    // headers
+
+    Elf64_Phdr program_headers[LINK_PROGRAM_HEADER_MAX_COUNT];
+    usize program_header_index = 0u;
+
+    if (is_dynamic) {
+        program_headers[program_header_index] = (Elf64_Phdr) {
+            .p_type = PT_PHDR,
+            .p_flags = PF_R,
+            .p_offset = sizeof (Elf64_Ehdr),
+            .p_vaddr = LINK_BASE_ADDRESS + sizeof (Elf64_Ehdr),
+            .p_paddr = LINK_BASE_ADDRESS + sizeof (Elf64_Ehdr),
+            .p_filesz = program_header_count * sizeof (Elf64_Phdr),
+            .p_memsz = program_header_count * sizeof (Elf64_Phdr),
+            .p_align = 8u,
+        };
+        program_header_index += 1u;
+        program_headers[program_header_index] = (Elf64_Phdr) {
+            .p_type = PT_INTERP,
+            .p_flags = PF_R,
+            .p_offset = interp_offset,
+            .p_vaddr = LINK_BASE_ADDRESS + interp_offset,
+            .p_paddr = LINK_BASE_ADDRESS + interp_offset,
+            .p_filesz = interp_len,
+            .p_memsz = interp_len,
+            .p_align = 1u,
+        };
+        program_header_index += 1u;
+    }
+
+    program_headers[program_header_index] = (Elf64_Phdr) {
+        .p_type = PT_LOAD,
+        .p_flags = PF_R,
+        .p_offset = 0u,
+        .p_vaddr = LINK_BASE_ADDRESS,
+        .p_paddr = LINK_BASE_ADDRESS,
+        .p_filesz = read_only_end,
+        .p_memsz = read_only_end,
+        .p_align = LINK_PAGE_LEN,
+    };
+    program_header_index += 1u;
+    program_headers[program_header_index] = (Elf64_Phdr) {
+        .p_type = PT_LOAD,
+        .p_flags = PF_R | PF_X,
+        .p_offset = text_offset,
+        .p_vaddr = text_address,
+        .p_paddr = text_address,
+        .p_filesz = text_end - text_offset,
+        .p_memsz = text_end - text_offset,
+        .p_align = LINK_PAGE_LEN,
+    };
+    program_header_index += 1u;
+    program_headers[program_header_index] = (Elf64_Phdr) {
+        .p_type = PT_LOAD,
+        .p_flags = PF_R | PF_W,
+        .p_offset = writable_offset,
+        .p_vaddr = LINK_BASE_ADDRESS + writable_offset,
+        .p_paddr = LINK_BASE_ADDRESS + writable_offset,
+        .p_filesz = file_len - writable_offset,
+        .p_memsz = writable_end - writable_offset,
+        .p_align = LINK_PAGE_LEN,
+    };
+    program_header_index += 1u;
+
+    if (is_dynamic) {
+        program_headers[program_header_index] = (Elf64_Phdr) {
+            .p_type = PT_DYNAMIC,
+            .p_flags = PF_R | PF_W,
+            .p_offset = dynamic_offset,
+            .p_vaddr = LINK_BASE_ADDRESS + dynamic_offset,
+            .p_paddr = LINK_BASE_ADDRESS + dynamic_offset,
+            .p_filesz = dynamic_len,
+            .p_memsz = dynamic_len,
+            .p_align = 8u,
+        };
+        program_header_index += 1u;
+    }
+
+    program_headers[program_header_index] = (Elf64_Phdr) {
+        .p_type = PT_GNU_STACK,
+        .p_flags = PF_R | PF_W,
+        .p_align = 16u,
+    };
+    program_header_index += 1u;
+
+    Elf64_Ehdr const header = {
+        .e_ident = {
+            ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3,
+            ELFCLASS64,
+            ELFDATA2LSB,
+            EV_CURRENT,
+            ELFOSABI_SYSV,
+        },
+        .e_type = ET_EXEC,
+        .e_machine = EM_X86_64,
+        .e_version = EV_CURRENT,
+        .e_entry = text_address,
+        .e_phoff = sizeof (Elf64_Ehdr),
+        .e_ehsize = sizeof (Elf64_Ehdr),
+        .e_phentsize = sizeof (Elf64_Phdr),
+        .e_phnum = (u16) program_header_count,
+    };
+
+    memcpy(image, &header, sizeof (header));
+    memcpy(image + sizeof (header), program_headers, program_header_count * sizeof (Elf64_Phdr));
+
+    writer_write_bytes(writer, image, file_len);
+
+    if (statistics_out != NULL) {
+        *statistics_out = (struct LinkStatistics) {
+            .text_len = text_len,
+            .data_len = data_len + rodata_len,
+            .import_count = import_count,
+            .is_dynamic = is_dynamic,
+        };
+    }
+
+    free(image);
+    free(layouts);
+    link_symbols_free(&symbols);
+
+    return true;
+}
@@ -1,22 +1,324 @@
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "cc/arena.h"
 #include "cc/ast.h"
+#include "cc/chunk_list.h"
 #include "cc/common.h"
 #include "cc/compile.h"
+#include "cc/compile/encoder.h"
 #include "cc/compile/error.h"
+#include "cc/elf_object.h"
+#include "cc/interner.h"
+#include "cc/jit.h"
+#include "cc/linker.h"
 #include "cc/lexer.h"
 #include "cc/log.h"
 #include "cc/parser.h"
-#include "cc/read_file_to_string.h"
+#include "cc/source_buffer.h"
+#include "cc/source_map.h"
 #include "cc/token.h"
+#include "cc/token_stream.h"
 #include "cc/vec.h"
 #include "cc/writer.h"
 
 #define ARENA_BLOCK_LEN (1024 * 1024)
+// address space reserved for the AST, only the pages that are used are committed
+#define AST_ARENA_RESERVE_LEN ((usize) 64u << 30u)
+// sources at least this large get their AST on transparent huge pages
+#define AST_ARENA_HUGE_PAGE_SOURCE_LEN (16u * 1024u * 1024u)
+
+#define ASSEMBLY_PATH "output/test.asm"
+#define OBJECT_PATH "output/test.o"
+#define EXECUTABLE_PATH "output/test"
+
+enum OutputKind {
+    // linked in-process
+    OutputExecutable,
+    // linked with ld
+    OutputObject,
+    // assembled with nasm and linked with ld
+    OutputAssembly,
+    // nothing is written, the code is run in-process
+    OutputJit,
+};
+
+static u64 monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (u64) now.tv_sec * 1000000000u + (u64) now.tv_nsec;
+}
+
+static void report_compile_error(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct CompileError const *const error
+) {
+    writer_writef(stdout_writer, "[%sCompile Error%s] ", color_red, color_reset);
+    format_compile_error(stdout_writer, sources, error);
+    writer_write(stdout_writer, "\n");
+}
+
+// writes the assembly for `ast` and assembles it with nasm
+static bool compile_to_assembly(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct AstRoot *const ast
+) {
+    // the assembly is streamed to the file as it is generated
+    i32 const assembly_fd = open(ASSEMBLY_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (assembly_fd < 0) {
+        log_error("could not open %s: %s", ASSEMBLY_PATH, strerror(errno));
+        exit(1);
+    }
+
+    struct ChunkList assembly;
+    chunk_list_init(&assembly, assembly_fd);
+
+    struct CompileResult const compile_result = compile(&assembly, ast);
+
+    if (compile_result.ok) {
+        chunk_list_flush(&assembly);
+    }
+    chunk_list_free(&assembly);
+    close(assembly_fd);
+
+    if (!compile_result.ok) {
+        // do not leave a partial file behind
+        remove(ASSEMBLY_PATH);
+        report_compile_error(stdout_writer, sources, &compile_result.error);
+        return false;
+    }
+
+    // the assembly is not kept in memory, so show it from the file
+    struct SourceBuffer assembly_file;
+    if (source_buffer_open(&assembly_file, ASSEMBLY_PATH)) {
+        writer_write(stdout_writer, "Assembly:\n");
+        writer_write_bytes(stdout_writer, assembly_file.data, assembly_file.len);
+        writer_write(stdout_writer, "\n");
+        source_buffer_free(&assembly_file);
+    } else {
+        log_warning("could not read back %s: %s", ASSEMBLY_PATH, strerror(errno));
+    }
+    writer_flush(stdout_writer);
+
+    log_trace("Assembling (nasm)");
+
+    system("nasm -f elf64 " ASSEMBLY_PATH);
+
+    return true;
+}
+
+// encodes `ast` into `text` and `data`, which are left for the caller to free
+static bool compile_to_code(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct AstRoot *const ast,
+    struct CodeBuffer *const text,
+    struct CodeBuffer *const data
+) {
+    code_buffer_init(text);
+    code_buffer_init(data);
+
+    struct CompileResult const compile_result = compile_code(text, data, ast);
+
+    if (!compile_result.ok) {
+        report_compile_error(stdout_writer, sources, &compile_result.error);
+        return false;
+    }
+
+    writer_writef(
+        stdout_writer, 
+        "Code: %zu bytes of text, %zu bytes of data, %zu external references\n\n", 
+        text->bytes.len, 
+        data->bytes.len, 
+        text->fixups.len
+    );
+    writer_flush(stdout_writer);
+
+    return true;
+}
+
+// encodes `ast` and writes the object file directly
+static bool compile_to_object(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct AstRoot *const ast
+) {
+    struct CodeBuffer text;
+    struct CodeBuffer data;
+
+    if (!compile_to_code(stdout_writer, sources, ast, &text, &data)) {
+        code_buffer_free(&text);
+        code_buffer_free(&data);
+        return false;
+    }
+
+    log_trace("Writing object");
+
+    FILE *const object_file = fopen(OBJECT_PATH, "wb");
+    if (object_file == NULL) {
+        log_error("could not open %s: %s", OBJECT_PATH, strerror(errno));
+        exit(1);
+    }
+
+    struct Writer object_writer = file_writer(object_file);
+    elf_write_object(
+        &object_writer, 
+        &(struct ObjectSections) {
+            .text = &text,
+            .data = &data,
+            .rodata = NULL,
+            .bss_len = 0u,
+        }
+    );
+    writer_free(&object_writer);
+
+    if (ferror(object_file) != 0 || fclose(object_file) != 0) {
+        log_error("could not write %s", OBJECT_PATH);
+        exit(1);
+    }
+
+    code_buffer_free(&text);
+    code_buffer_free(&data);
+
+    return true;
+}
+
+// encodes `ast` and links the executable in-process
+static bool compile_to_executable(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct AstRoot *const ast,
+    enum LinkMode const link_mode
+) {
+    struct CodeBuffer text;
+    struct CodeBuffer data;
+
+    bool ok = compile_to_code(stdout_writer, sources, ast, &text, &data);
+
+    if (ok) {
+        log_trace("Linking");
+
+        i32 const executable_fd = open(EXECUTABLE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        if (executable_fd < 0) {
+            log_error("could not open %s: %s", EXECUTABLE_PATH, strerror(errno));
+            exit(1);
+        }
+
+        struct ChunkList executable;
+        chunk_list_init(&executable, executable_fd);
+        struct Writer executable_writer = chunk_list_writer(&executable);
+
+        struct LinkStatistics link_statistics;
+        ok = link_executable(
+            &executable_writer,
+            &(struct ObjectSections) {
+                .text = &text,
+                .data = &data,
+                .rodata = NULL,
+                .bss_len = 0u,
+            },
+            1u,
+            link_mode,
+            &link_statistics
+        );
+
+        if (ok) {
+            chunk_list_flush(&executable);
+            // an existing file keeps its mode
+            fchmod(executable_fd, 0755);
+
+            log_trace(
+                "Linked %s executable: %zu bytes of text, %zu functions imported", 
+                link_statistics.is_dynamic ? "dynamic" : "static",
+                link_statistics.text_len,
+                link_statistics.import_count
+            );
+        }
+        chunk_list_free(&executable);
+        close(executable_fd);
+
+        if (!ok) {
+            remove(EXECUTABLE_PATH);
+        }
+    }
 
-i32 main(void) {
+    code_buffer_free(&text);
+    code_buffer_free(&data);
+
+    return ok;
+}
+
+// encodes `ast`, loads it into this process and runs its main, whose return value is stored in
+// `exit_code_out`
+// `start_ns` is when compilation started (before lexing), for the reported compile time
+static bool compile_and_run(
+    struct Writer *const stdout_writer, 
+    struct SourceMap *const sources, 
+    struct AstRoot *const ast,
+    u64 const start_ns,
+    bool const write_perf_map,
+    bool const write_jitdump,
+    i32 *const exit_code_out
+) {
+    struct CodeBuffer text;
+    struct CodeBuffer data;
+
+    bool ok = compile_to_code(stdout_writer, sources, ast, &text, &data);
+
+    struct JitProgram program;
+    if (ok) {
+        log_trace("Loading");
+
+        ok = jit_load(&program, &text, &data);
+    }
+
+    if (ok) {
+        u64 const loaded_ns = monotonic_ns();
+
+        // the files are for profiling the run, so a failure to write them is not fatal
+        if (write_perf_map) {
+            jit_write_perf_map(&program);
+        }
+        if (write_jitdump) {
+            jit_write_jitdump(&program);
+        }
+
+        log_trace("Running");
+        // the program shares stdout with the compiler
+        writer_flush(stdout_writer);
+
+        u64 const run_start_ns = monotonic_ns();
+        *exit_code_out = jit_call_main(&program);
+        u64 const run_end_ns = monotonic_ns();
+
+        fflush(stdout);
+
+        log_trace(
+            "Compile time: %.3f ms, run time: %.3f ms, exit code %d", 
+            (double) (loaded_ns - start_ns) / 1e6,
+            (double) (run_end_ns - run_start_ns) / 1e6,
+            *exit_code_out
+        );
+
+        jit_free(&program);
+    }
+
+    code_buffer_free(&text);
+    code_buffer_free(&data);
+
+    return ok;
+}
+
+i32 main(i32 const argc, char **const argv) {
     struct Writer stdout_writer = file_writer(stdout);
 
     log_init(
@@ -26,87 +328,176 @@ i32 main(void) {
         NULL
     );
 
-    char const *const source = read_file_to_string("input/test.c");
+    enum OutputKind output_kind = OutputExecutable;
+    enum LinkMode link_mode = LinkAuto;
+    bool write_perf_map = false;
+    bool write_jitdump = false;
+    for (i32 i = 1; i < argc; i += 1) {
+        if (strcmp(argv[i], "--asm") == 0) {
+            output_kind = OutputAssembly;
+        } else if (strcmp(argv[i], "--object") == 0) {
+            output_kind = OutputObject;
+        } else if (strcmp(argv[i], "--static") == 0) {
+            link_mode = LinkStatic;
+        } else if (strcmp(argv[i], "--dynamic") == 0) {
+            link_mode = LinkDynamic;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            output_kind = OutputJit;
+        } else if (strcmp(argv[i], "--perf-map") == 0) {
+            write_perf_map = true;
+        } else if (strcmp(argv[i], "--jitdump") == 0) {
+            write_jitdump = true;
+        } else {
+            log_error("unknown argument: %s", argv[i]);
+            exit(1);
+        }
+    }
 
-    // Lexical analysis
+    if ((write_perf_map || write_jitdump) && output_kind != OutputJit) {
+        log_error("--perf-map and --jitdump need --jit");
+        exit(1);
+    }
+
+    u64 const start_ns = monotonic_ns();
+
+    char const *const source_path = "input/test.c";
 
-    log_trace("Lexical analysis");
+    struct SourceMap sources;
+    source_map_init(&sources);
 
-    struct TokenVec tokens = tokenize(source);
+    u32 source_file;
+    if (!source_map_add_file(&sources, source_path, &source_file)) {
+        log_error("could not read %s: %s", source_path, strerror(errno));
+        exit(1);
+    }
 
-    puts("Tokens: ");
-    tokenvec_debug(&stdout_writer, &tokens);
-    puts("\n");
+    char const *const source = source_map_file(&sources, source_file)->buffer.data;
 
-    // Syntax analysis
+    // Lexical and syntax analysis
+    // (the parser pulls tokens from the lexer as it needs them)
 
-    log_trace("Syntax analysis");
+    log_trace("Lexical and syntax analysis");
+
+    struct Interner interner;
+    interner_init(&interner);
+
+    struct TokenStream tokens;
+    token_stream_init_lexer(&tokens, source, source_file, &interner);
 
     struct Arena ast_arena;
-    arena_init(&ast_arena, ARENA_BLOCK_LEN);
+    bool const use_huge_pages 
+        = source_map_file(&sources, source_file)->buffer.len >= AST_ARENA_HUGE_PAGE_SOURCE_LEN;
+    if (!arena_init_reserved(&ast_arena, ARENA_BLOCK_LEN, AST_ARENA_RESERVE_LEN, use_huge_pages)) {
+        log_warning("could not reserve address space for the AST, falling back to heap blocks");
+        arena_init(&ast_arena, ARENA_BLOCK_LEN);
+    }
 
     struct AstRoot ast;
+    struct ParseStatistics parse_statistics;
     struct ParseResult const parse_result = parse(
         &ast, 
-        tokenvec_slice_whole(&tokens),
-        &ast_arena
+        &tokens,
+        &ast_arena,
+        &parse_statistics
+    );
+
+    log_trace(
+        "Parser memo: %zu hits, %zu misses", 
+        parse_statistics.memo_hits, 
+        parse_statistics.memo_misses
+    );
+    log_trace(
+        "Token stream: %zu tokens buffered at most, %zu bytes", 
+        tokens.variant.lexer.tokens.capacity,
+        token_store_memory_usage(&tokens.variant.lexer.tokens)
     );
 
+    struct ArenaStatistics const ast_arena_statistics = arena_statistics(&ast_arena);
+    log_trace(
+        "AST arena: %zu bytes requested, %zu bytes wasted, %zu bytes in %zu blocks", 
+        ast_arena_statistics.bytes_requested,
+        ast_arena_statistics.bytes_wasted,
+        ast_arena_statistics.bytes_reserved,
+        ast_arena_statistics.block_count
+    );
+
+    struct InternerStatistics const symbol_statistics = interner_statistics(&interner);
+    log_trace(
+        "Interner: %zu symbols, %zu bytes stored, table size %zu", 
+        symbol_statistics.symbol_count,
+        symbol_statistics.bytes_stored,
+        symbol_statistics.table_size
+    );
+
+    token_stream_free(&tokens);
+
     if (!parse_result.ok) {
-        printf("[%sParse Error%s] ", color_red, color_reset);
-        format_parse_error(&stdout_writer, &parse_result.error);
-        printf("\n");
+        writer_writef(&stdout_writer, "[%sParse Error%s] ", color_red, color_reset);
+        format_parse_error(&stdout_writer, &sources, &parse_result.error);
+        writer_write(&stdout_writer, "\n");
+        writer_free(&stdout_writer);
         return 1;
     }
 
-    puts("AST:");
+    writer_write(&stdout_writer, "AST:\n");
     ast_debug_root(&stdout_writer, &ast);
-    puts("\n");
+    writer_write(&stdout_writer, "\n\n");
+    // the log writes to stdout too
+    writer_flush(&stdout_writer);
 
     // Compiling
 
     log_trace("Compiling");
 
-    struct CharVec assembly_string;
-    charvec_init(&assembly_string);
-
-    struct Writer assembly_writer = charvec_writer(&assembly_string);
-
-    struct CompileResult const compile_result = compile(&assembly_writer, &ast);
+    bool compiled = false;
+    i32 exit_code = 0;
+    switch (output_kind) {
+        case OutputExecutable: {
+            compiled = compile_to_executable(&stdout_writer, &sources, &ast, link_mode);
+            break;
+        }
+        case OutputObject: {
+            compiled = compile_to_object(&stdout_writer, &sources, &ast);
+            break;
+        }
+        case OutputAssembly: {
+            compiled = compile_to_assembly(&stdout_writer, &sources, &ast);
+            break;
+        }
+        case OutputJit: {
+            compiled = compile_and_run(
+                &stdout_writer, 
+                &sources, 
+                &ast, 
+                start_ns, 
+                write_perf_map, 
+                write_jitdump, 
+                &exit_code
+            );
+            break;
+        }
+    }
 
-    if (!compile_result.ok) {
-        printf("[%sCompile Error%s] ", color_red, color_reset);
-        format_compile_error(&stdout_writer, &compile_result.error);
-        printf("\n");
+    if (!compiled) {
+        writer_free(&stdout_writer);
         exit(1);
     }
 
-    FILE *const asm_file = fopen("output/test.asm", "w");
-    fwrite(assembly_string.data, sizeof (char), assembly_string.len, asm_file);
-    fclose(asm_file);
-
-    puts("Assembly:");
-    writer_write_charslice(&stdout_writer, charvec_slice_whole(&assembly_string));
-    puts("");
+    // Linking (the executable is already linked unless an object file was written)
 
-    // Assembling 
+    if (output_kind == OutputObject || output_kind == OutputAssembly) {
+        log_trace("Linking (ld)");
 
-    log_trace("Assembling (nasm)");
-
-    system("nasm -f elf64 output/test.asm");
-
-    // Linking 
-
-    log_trace("Linking (ld)");
-
-    system("ld -dynamic-linker /lib64/ld-linux-x86-64.so.2 -o output/test output/test.o /usr/lib/crt1.o /usr/lib/crti.o /usr/lib/crtn.o -lc -L/lib64");
+        system("ld -dynamic-linker /lib64/ld-linux-x86-64.so.2 -o " EXECUTABLE_PATH " " OBJECT_PATH " /usr/lib/crt1.o /usr/lib/crti.o /usr/lib/crtn.o -lc -L/lib64");
+    }
 
     // Cleanup
 
-    charvec_free(&assembly_string);
+    writer_free(&stdout_writer);
     arena_free(&ast_arena);
-    tokenvec_free(&tokens);
+    interner_free(&interner);
+    source_map_free(&sources);
 
-    return 0;
+    return exit_code;
 }
 
@@ -1,5 +1,6 @@
 #include "cc/map.h"
 #include "cc/hash.h"
+#include "cc/interner.h"
 #include "cc/slice.h"
 
 #define MAP_TYPE            Map__CharSlice_usize
@@ -7,11 +8,28 @@
 #define MAP_VALUE_TYPE      usize
 #define MAP_FUNCTION_PREFIX map__charslice_usize__
 #define MAP_KEY_EQ_FN       charslice_eq
-#define MAP_KEY_HASH_FN     charslice_hash_djb2
-#include "cc/template/map.inl"
+#define MAP_KEY_HASH_FN     charslice_hash
+#include "cc/template/flat_map.inl"
 #undef MAP_TYPE            
 #undef MAP_KEY_TYPE 
 #undef MAP_VALUE_TYPE      
 #undef MAP_FUNCTION_PREFIX 
 #undef MAP_KEY_EQ_FN       
 #undef MAP_KEY_HASH_FN     
+
+
+#define MAP_TYPE            Map__u32_usize
+#define MAP_KEY_TYPE        u32
+#define MAP_VALUE_TYPE      usize
+#define MAP_FUNCTION_PREFIX map__u32_usize__
+#define MAP_KEY_EQ_FN       symbol_eq
+#define MAP_KEY_HASH_FN     symbol_hash
+#define MAP_ALLOCATOR
+#include "cc/template/flat_map.inl"
+#undef MAP_TYPE            
+#undef MAP_KEY_TYPE 
+#undef MAP_VALUE_TYPE      
+#undef MAP_FUNCTION_PREFIX 
+#undef MAP_KEY_EQ_FN       
+#undef MAP_KEY_HASH_FN     
+#undef MAP_ALLOCATOR
@@ -1,71 +1,309 @@
 #include "cc/parser.h"
 
-#include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "cc/arena.h"
 #include "cc/ast.h"
 #include "cc/log.h"
 #include "cc/token.h"
+#include "cc/token_stream.h"
 #include "cc/vec.h"
 
 #define PARSER_FAIL_ON(PARSER, RESULT)                  \
     do {                                                \
         struct ParseResult const result = (RESULT);     \
         if (!result.ok) {                               \
-            return parser_fail(PARSER, result.error);   \
+            return parser_fail(PARSER);                 \
         }                                               \
     } while (false);
 
+// defines `NAME` as a memoized wrapper around `NAME##_uncached`, so that the rule runs at 
+// most once per token position
+#define PARSER_MEMOIZE(NAME, NODE_TYPE, RULE)                                               \
+    static struct ParseResult NAME(NODE_TYPE *const out, struct Parser *const parser) {     \
+        struct ParseResult result;                                                          \
+        if (parser_memo_lookup(parser, RULE, out, sizeof *out, &result)) {                  \
+            return result;                                                                  \
+        }                                                                                   \
+        usize const start_position = parser_position(parser);                               \
+        result = NAME##_uncached(out, parser);                                              \
+        parser_memo_store(parser, RULE, start_position, out, sizeof *out, result);          \
+        return result;                                                                      \
+    }
+
+#define PARSER_MEMO_TABLE_SIZE 64u
+
+// rules whose results are memoized 
+// (expressions are parsed without backtracking, so only statement-level alternatives can 
+// start the same rule twice at one position)
+enum ParseRule {
+    ParseRuleExpression,
+    ParseRuleCount,
+};
+
+// result of running a rule at some token position
+struct ParseMemoEntry {
+    struct ParseResult result;
+    // token position after the rule (only meaningful on success)
+    usize end_position;
+    // copy of the node produced by the rule, in the AST arena (NULL on failure)
+    void const *node;
+};
+
+static usize parse_memo_key_hash(usize const key) {
+    return key;
+}
+
+static bool parse_memo_key_eq(usize const left, usize const right) {
+    return left == right;
+}
+
+#define MAP_TYPE            Map__usize_ParseMemoEntry
+#define MAP_KEY_TYPE        usize
+#define MAP_VALUE_TYPE      struct ParseMemoEntry
+#define MAP_FUNCTION_PREFIX map__usize_parsememoentry__
+#define MAP_KEY_EQ_FN       parse_memo_key_eq
+#define MAP_KEY_HASH_FN     parse_memo_key_hash
+#include "cc/template/flat_map.h"
+#include "cc/template/flat_map.inl"
+#undef MAP_TYPE            
+#undef MAP_KEY_TYPE 
+#undef MAP_VALUE_TYPE      
+#undef MAP_FUNCTION_PREFIX 
+#undef MAP_KEY_EQ_FN       
+#undef MAP_KEY_HASH_FN     
+
+// a rule in progress
+struct ParserFrame {
+    // position of the next token for the rule
+    usize position;
+    // source position of the rule's first token
+    struct TokenPosition position_start;
+    // AST arena position when the rule started, so a failed rule frees the nodes it built
+    struct ArenaMark arena_mark;
+    // length of the memo log when the rule started
+    usize memo_log_len;
+};
+
+#define SLICE_TYPE ParserFrameSlice 
+#define SLICE_ELEMENT_TYPE struct ParserFrame
+#define SLICE_FUNCTION_PREFIX parserframeslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+// rules rarely nest deeper than this, so the frame stack normally lives inside the parser
+#define SMALLVEC_TYPE ParserFrameSmallVec
+#define SMALLVEC_ELEMENT_TYPE struct ParserFrame
+#define SMALLVEC_INLINE_CAPACITY 32u
+#define SMALLVEC_SLICE_TYPE ParserFrameSlice
+#define SMALLVEC_FUNCTION_PREFIX parserframesmallvec_
+#include "cc/template/small_vec.h"
+#include "cc/template/small_vec.inl"
+#undef SMALLVEC_TYPE
+#undef SMALLVEC_ELEMENT_TYPE
+#undef SMALLVEC_INLINE_CAPACITY
+#undef SMALLVEC_SLICE_TYPE
+#undef SMALLVEC_FUNCTION_PREFIX
+
+// arguments of a call being parsed, copied to the AST arena once the call is complete
+#define SLICE_TYPE AstExpressionSlice 
+#define SLICE_ELEMENT_TYPE struct AstExpression
+#define SLICE_FUNCTION_PREFIX astexpressionslice_
+#include "cc/template/slice.h"
+#undef SLICE_TYPE
+#undef SLICE_ELEMENT_TYPE
+#undef SLICE_FUNCTION_PREFIX
+
+#define SMALLVEC_TYPE AstExpressionSmallVec
+#define SMALLVEC_ELEMENT_TYPE struct AstExpression
+#define SMALLVEC_INLINE_CAPACITY 8u
+#define SMALLVEC_SLICE_TYPE AstExpressionSlice
+#define SMALLVEC_FUNCTION_PREFIX astexpressionsmallvec_
+#include "cc/template/small_vec.h"
+#include "cc/template/small_vec.inl"
+#undef SMALLVEC_TYPE
+#undef SMALLVEC_ELEMENT_TYPE
+#undef SMALLVEC_INLINE_CAPACITY
+#undef SMALLVEC_SLICE_TYPE
+#undef SMALLVEC_FUNCTION_PREFIX
+
+// the failure that got furthest into the token stream
+// alternatives are tried in turn, so rather than building an error for every failed 
+// alternative, the parser only remembers what it expected at the furthest position any rule 
+// reached, and the error is built from that once the whole parse has failed
+struct ParseFailure {
+    // token position of the failure
+    usize position;
+    // bit set of the token kinds expected at `position`
+    u64 expected;
+    // an invalid integer type ended at `position`
+    bool is_invalid_integer_type;
+    struct TokenPosition invalid_integer_type_position;
+};
+
 struct Parser {
-    struct UsizeVec position_stack;
-    struct TokenSlice tokens;
+    struct ParserFrameSmallVec frame_stack;
+    struct TokenStream *tokens;
     struct Arena *ast_arena;
     struct Token last_token;
+    // packrat memo table, keyed by (token position, rule)
+    struct Map__usize_ParseMemoEntry memo;
+    // keys of the memo entries stored since the last commit, oldest first
+    struct UsizeVec memo_log;
+    struct ParseStatistics statistics;
+    struct ParseFailure furthest_failure;
 };
 
-typedef struct ParseResult (*ExpressionParseFn)(struct AstExpression *, struct Parser *);
-
 static void parser_init(
     struct Parser *const self, 
-    struct TokenSlice const tokens, 
+    struct TokenStream *const tokens, 
     struct Arena *const ast_arena
 ) {
     self->tokens = tokens;
     self->ast_arena = ast_arena;
     self->last_token = (struct Token) { .kind = TokenUnknown };
+    self->statistics = (struct ParseStatistics) { .memo_hits = 0u, .memo_misses = 0u };
+    self->furthest_failure = (struct ParseFailure) {
+        .position = 0u,
+        .expected = 0u,
+        .is_invalid_integer_type = false,
+    };
 
-    usizevec_init(&self->position_stack);
-    usizevec_push(&self->position_stack, 0u);
+    parserframesmallvec_init(&self->frame_stack);
+    parserframesmallvec_push(
+        &self->frame_stack, 
+        (struct ParserFrame) {
+            .position = 0u,
+            .position_start = token_stream_position_at(tokens, 0u),
+            .arena_mark = arena_mark(ast_arena),
+            .memo_log_len = 0u,
+        }
+    );
+
+    map__usize_parsememoentry__init(&self->memo, PARSER_MEMO_TABLE_SIZE);
+    usizevec_init(&self->memo_log);
 }
 
 static void parser_free(struct Parser *const self) {
-    usizevec_free(&self->position_stack);
+    parserframesmallvec_free(&self->frame_stack);
+    map__usize_parsememoentry__free(&self->memo);
+    usizevec_free(&self->memo_log);
 }
 
-static struct Token parser_peek(struct Parser const *const self) {
-    usize const position = *usizevec_peek_back(&self->position_stack);
+static usize parser_position(struct Parser const *const self) {
+    return parserframesmallvec_peek_back(&self->frame_stack)->position;
+}
 
-    if (position < self->tokens.len) {
-        return self->tokens.ptr[position];
-    } else {
-        return (struct Token) { .kind = TokenUnknown };
+static usize parse_memo_key(usize const position, enum ParseRule const rule) {
+    return position * ParseRuleCount + (usize) rule;
+}
+
+// if `rule` has already run at the current position, replays its result (copying the node it 
+// produced to `out` and skipping the tokens it consumed) and returns true
+static bool parser_memo_lookup(
+    struct Parser *const self,
+    enum ParseRule const rule,
+    void *const out,
+    usize const node_size,
+    struct ParseResult *const result_out
+) {
+    struct ParseMemoEntry const *const entry = map__usize_parsememoentry__get(
+        &self->memo, 
+        parse_memo_key(parser_position(self), rule)
+    );
+
+    if (entry == NULL) {
+        self->statistics.memo_misses += 1u;
+        return false;
     }
+
+    self->statistics.memo_hits += 1u;
+
+    if (entry->result.ok) {
+        memcpy(out, entry->node, node_size);
+        parserframesmallvec_peek_back(&self->frame_stack)->position = entry->end_position;
+        self->last_token = token_stream_at(self->tokens, entry->end_position - 1u);
+    }
+
+    *result_out = entry->result;
+    return true;
+}
+
+// records the result of running `rule` at `start_position`
+static void parser_memo_store(
+    struct Parser *const self,
+    enum ParseRule const rule,
+    usize const start_position,
+    void const *const node,
+    usize const node_size,
+    struct ParseResult const result
+) {
+    struct ParseMemoEntry const entry = {
+        .result = result,
+        .end_position = parser_position(self),
+        .node = result.ok ? arena_copy(self->ast_arena, node, node_size) : NULL,
+    };
+
+    usize const key = parse_memo_key(start_position, rule);
+    map__usize_parsememoentry__set(&self->memo, key, entry);
+    usizevec_push(&self->memo_log, key);
+}
+
+// forgets the successful memo entries stored since the memo log had length `log_len`, as the 
+// nodes they copy are about to be released from the AST arena
+// failed entries hold no nodes, so they stay valid
+static void parser_memo_rollback(struct Parser *const self, usize const log_len) {
+    usize kept_len = log_len;
+
+    for (usize log_index = log_len; log_index < self->memo_log.len; log_index += 1u) {
+        usize const key = self->memo_log.data[log_index];
+        struct ParseMemoEntry const *const entry = map__usize_parsememoentry__get(&self->memo, key);
+
+        if (entry != NULL && entry->result.ok) {
+            map__usize_parsememoentry__remove(&self->memo, key);
+        } else if (entry != NULL) {
+            self->memo_log.data[kept_len] = key;
+            kept_len += 1u;
+        }
+    }
+
+    self->memo_log.len = kept_len;
+}
+
+// kind of the token `n` tokens past the next token
+// lookahead only reads token kinds, full tokens are only materialized once consumed
+static enum TokenKind parser_peek_kind_nth(struct Parser const *const self, usize const n) {
+    return token_stream_kind_at(self->tokens, parser_position(self) + n);
+}
+
+static enum TokenKind parser_peek_kind(struct Parser const *const self) {
+    return parser_peek_kind_nth(self, 0u);
+}
+
+static struct Token parser_peek(struct Parser const *const self) {
+    return token_stream_at(self->tokens, parser_position(self));
 }
 
 static struct Token parser_next(struct Parser *const self) {
     struct Token const next = parser_peek(self);
     self->last_token = next;
-    *usizevec_peek_back(&self->position_stack) += 1u;
+    parserframesmallvec_peek_back(&self->frame_stack)->position += 1u;
     return next;
 }
 
 // push current token position onto the stack 
 static void parser_push_position(struct Parser *const self) {
-    usize const position = *usizevec_peek_back(&self->position_stack);
-    usizevec_push(
-        &self->position_stack, 
-        position
+    parserframesmallvec_push(
+        &self->frame_stack, 
+        (struct ParserFrame) {
+            .position = parser_position(self),
+            .position_start = token_stream_position_at(self->tokens, parser_position(self)),
+            .arena_mark = arena_mark(self->ast_arena),
+            .memo_log_len = self->memo_log.len,
+        }
     );
 }
 
@@ -74,10 +312,10 @@ static struct ParseResult parser_success(
     struct Parser *const self, 
     struct AstNodePosition *const out_ast_node_position
 ) {
-    usize const new_position = usizevec_pop_back(&self->position_stack);
-    out_ast_node_position->position_start = parser_peek(self).position;
+    struct ParserFrame const frame = parserframesmallvec_pop_back(&self->frame_stack);
+    out_ast_node_position->position_start = frame.position_start;
     out_ast_node_position->position_end = self->last_token.position;
-    *usizevec_peek_back(&self->position_stack) = new_position;
+    parserframesmallvec_peek_back(&self->frame_stack)->position = frame.position;
 
     return (struct ParseResult) {
         .ok = true,
@@ -85,22 +323,67 @@ static struct ParseResult parser_success(
 }
 
 // reject token position and return error result
-static struct ParseResult parser_fail(struct Parser *const self, struct ParseError const error) {
-    usizevec_pop_back(&self->position_stack);
+// the reason for the failure is recorded separately, see `parser_record_expected`
+static struct ParseResult parser_fail(struct Parser *const self) {
+    struct ParserFrame const frame = parserframesmallvec_pop_back(&self->frame_stack);
+
+    // nothing the rule built is reachable any more
+    parser_memo_rollback(self, frame.memo_log_len);
+    arena_reset_to_mark(self->ast_arena, frame.arena_mark);
 
     return (struct ParseResult) {
         .ok = false,
-        .error = error,
     };
 }
 
+// makes the furthest failure the one at the current position if it is at least as far, and 
+// returns whether it is
+static bool parser_reach_failure(struct Parser *const self) {
+    struct ParseFailure *const failure = &self->furthest_failure;
+    usize const position = parser_position(self);
+
+    if (position < failure->position) {
+        return false;
+    }
+    if (position > failure->position) {
+        failure->position = position;
+        failure->expected = 0u;
+        failure->is_invalid_integer_type = false;
+    }
+
+    return true;
+}
+
+// note that `token` would have been accepted at the current position 
+static void parser_record_expected(struct Parser *const self, enum TokenKind const token) {
+    if (parser_reach_failure(self)) {
+        self->furthest_failure.expected |= (u64) 1u << token;
+    }
+}
+
+// cut: no enclosing rule backtracks past the current position, so the token stream can 
+// release the tokens before it
+// the memo table is emptied too: entries before the current position can no longer be looked 
+// up, and dropping the rest keeps the table small at the cost of rarely recomputing a rule
+static void parser_commit(struct Parser *const self) {
+    token_stream_release(self->tokens, parser_position(self));
+
+    for (usize log_index = 0u; log_index < self->memo_log.len; log_index += 1u) {
+        map__usize_parsememoentry__remove(&self->memo, self->memo_log.data[log_index]);
+    }
+    self->memo_log.len = 0u;
+
+    // frames below the current one must not roll back past entries that no longer exist
+    for (usize frame_index = 0u; frame_index < self->frame_stack.len; frame_index += 1u) {
+        parserframesmallvec_at(&self->frame_stack, frame_index)->memo_log_len = 0u;
+    }
+}
+
 static bool parser_accept(
     struct Parser *const self,
     enum TokenKind const token
 ) {
-    struct Token const next = parser_peek(self);
-
-    if (next.kind == token) {
+    if (parser_peek_kind(self) == token) {
         parser_next(self);
         return true;
     } else {
@@ -117,102 +400,26 @@ static struct ParseResult parser_expect(
             .ok = true,
         };
     } else {
-        struct Token const next = parser_peek(self);
-        struct ParseError const error = {
-            .kind = ParseErrorExpectedToken,
-            .variant.expected_token = {
-                .position = next.position,
-                .got = next.kind,
-                .expected = token,
-            },
-        };
-
+        parser_record_expected(self, token);
         return (struct ParseResult) {
             .ok = false,
-            .error = error,
         };
     }
 }
 
-static struct ParseError join_parse_errors(
-    struct Arena *const arena,
-    usize const error_count,
-    ...
-) {
-    if (error_count < 2u) {
-        log_error("join_parse_errors called with fewer than 2 errors");
-        exit(1);
-    } 
-
-    va_list errors;
-    va_start(errors, error_count);
-
-    struct ParseError left  = va_arg(errors, struct ParseError);
-    struct ParseError right = va_arg(errors, struct ParseError);
-
-    for (usize error_index = 2u; error_index < error_count; error_index += 1) {
-        left = (struct ParseError) {
-            .kind = ParseErrorJoin,
-            .variant.join = {
-                .left = arena_copy(arena, &left, sizeof left),
-                .right = arena_copy(arena, &right, sizeof right),
-            },
-        };
-        right = va_arg(errors, struct ParseError);
-    }
-
-    va_end(errors);
-
-    return (struct ParseError) {
-        .kind = ParseErrorJoin,
-        .variant.join = {
-            .left = arena_copy(arena, &left, sizeof left),
-            .right = arena_copy(arena, &right, sizeof right),
-        },
-    };
-}
-
-// generic recursive descent parser for binary operations
-static struct ParseResult parse_binary_operation(
-    struct AstExpression *const out,
-    struct Parser *const parser,
-    // number of different operators
-    usize op_count,
-    // binary operations corresponding to each operator
-    enum AstBinaryOpKind const *ops,
-    // tokens corresponding to each operator
-    enum TokenKind const *tokens,
-    // parse function with the same precedence
-    ExpressionParseFn const same_precedence,
-    // parse function with the next precedence down
-    ExpressionParseFn const next_precedence
-) {
-    parser_push_position(parser);
-
-    struct AstExpression left;
-    PARSER_FAIL_ON(parser, next_precedence(&left, parser));
-
-    for (usize op_index = 0; op_index < op_count; op_index += 1) {
-        if (parser_accept(parser, tokens[op_index])) {
-            struct AstExpression right;
-            PARSER_FAIL_ON(parser, same_precedence(&right, parser));
-
-            *out = (struct AstExpression) {
-                .kind = AstExpressionBinaryOp,
-                .variant.binary_op = (struct AstBinaryOp) {
-                    .kind = ops[op_index],
-                    .left = arena_copy(parser->ast_arena, &left, sizeof left),
-                    .right = arena_copy(parser->ast_arena, &right, sizeof right),
-                },
-            };
-
-            return parser_success(parser, &out->position);
-        }       
-    }
+// binary operators, indexed by token kind
+// precedence 0 means the token is not a binary operator; higher precedence binds tighter
+struct BinaryOperator {
+    enum AstBinaryOpKind op;
+    usize precedence;
+};
 
-    *out = left;
-    return parser_success(parser, &out->position);
-}
+static struct BinaryOperator const binary_operators[TokenCount] = {
+    [TokenPlus]     = { AstBinaryOpAddition,       1u },
+    [TokenMinus]    = { AstBinaryOpSubtraction,    1u },
+    [TokenAsterisk] = { AstBinaryOpMultiplication, 2u },
+    [TokenSlash]    = { AstBinaryOpDivision,       2u },
+};
 
 // ---------------------
 //   parsing functions
@@ -236,6 +443,7 @@ static struct ParseResult parse_identifier(
     );
 
     out->name = parser->last_token.variant.identifier.name;
+    out->symbol = parser->last_token.variant.identifier.symbol;
     return parser_success(parser, &out->position);
 }
 
@@ -285,7 +493,7 @@ static struct ParseResult parse_bracketed_expression(
 }
 
 // argument_list = e | expression | argument_list `,` expression
-// call = expression `(` argument_list `)`
+// call = identifier `(` argument_list `)`
 static struct ParseResult parse_call(
     struct AstCall *const out, 
     struct Parser *const parser
@@ -305,111 +513,143 @@ static struct ParseResult parse_call(
     )
 
     // arguments
-    struct ArenaVec arguments;
-    arenavec_init(&arguments, parser->ast_arena, sizeof (struct AstExpression));
+    // (collected on the stack, nested calls would keep an arena vec from growing in place)
+    struct AstExpressionSmallVec arguments;
+    astexpressionsmallvec_init(&arguments);
 
     if (!parser_accept(parser, TokenRightParen)) {
-         do {
+        bool is_ok;
+        do {
             struct AstExpression expression;
-            PARSER_FAIL_ON(
-                parser, 
-                parse_expression(&expression, parser)
-            )
-            arenavec_push(&arguments, &expression);
-        } while (parser_accept(parser, TokenComma));
+            is_ok = parse_expression(&expression, parser).ok;
+            if (is_ok) {
+                astexpressionsmallvec_push(&arguments, expression);
+            }
+        } while (is_ok && parser_accept(parser, TokenComma));
 
         // `)`
-        PARSER_FAIL_ON(
-            parser, 
-            parser_expect(parser, TokenRightParen)
-        )
+        if (!is_ok || !parser_expect(parser, TokenRightParen).ok) {
+            astexpressionsmallvec_free(&arguments);
+            return parser_fail(parser);
+        }
     }
 
-    out->arguments = arguments.data;
     out->argument_count = arguments.len;
+    out->arguments = (arguments.len == 0u) 
+        ? NULL 
+        : arena_copy(
+            parser->ast_arena, 
+            astexpressionsmallvec_data(&arguments), 
+            arguments.len * sizeof (struct AstExpression)
+        );
+    astexpressionsmallvec_free(&arguments);
 
     return parser_success(parser, &out->position);
 }
 
-// primary_expression = identifier | constant | bracketed_expression | call
+// primary_expression = call | identifier | constant | bracketed_expression
+// the next token (and the one after for identifiers) selects the alternative
 static struct ParseResult parse_primary_expression(
     struct AstExpression *const out, 
     struct Parser *const parser
 ) {
     parser_push_position(parser);
 
-    struct ParseResult const call_result = parse_call(&out->variant.call, parser);
-    if (call_result.ok) {
-        out->kind = AstExpressionCall;
-        return parser_success(parser, &out->position);
+    switch (parser_peek_kind(parser)) {
+        case TokenIdentifier: {
+            if (parser_peek_kind_nth(parser, 1u) == TokenLeftParen) {
+                out->kind = AstExpressionCall;
+                PARSER_FAIL_ON(
+                    parser,
+                    parse_call(&out->variant.call, parser)
+                )
+            } else {
+                out->kind = AstExpressionIdentifier;
+                PARSER_FAIL_ON(
+                    parser,
+                    parse_identifier(&out->variant.identifier, parser)
+                )
+            }
+            break;
+        }
+        case TokenInteger: {
+            out->kind = AstExpressionConstant;
+            PARSER_FAIL_ON(
+                parser,
+                parse_constant(&out->variant.constant, parser)
+            )
+            break;
+        }
+        case TokenLeftParen: {
+            PARSER_FAIL_ON(
+                parser,
+                parse_bracketed_expression(out, parser)
+            )
+            break;
+        }
+        default: {
+            parser_record_expected(parser, TokenIdentifier);
+            parser_record_expected(parser, TokenInteger);
+            parser_record_expected(parser, TokenLeftParen);
+            return parser_fail(parser);
+        }
     }
 
-    struct ParseResult const identifier_result = parse_identifier(&out->variant.identifier, parser);
-    if (identifier_result.ok) {
-        out->kind = AstExpressionIdentifier;
-        return parser_success(parser, &out->position);
-    }
+    return parser_success(parser, &out->position);
+}
 
-    struct ParseResult const constant_result = parse_constant(&out->variant.constant, parser);
-    if (constant_result.ok) {
-        out->kind = AstExpressionConstant;
-        return parser_success(parser, &out->position);
-    }
+// binary_expression = primary_expression | binary_expression operator binary_expression
+// precedence climbing: operators of the same precedence are folded left-associatively in a 
+// loop, so the parser only recurses for operands of operators that bind more tightly
+static struct ParseResult parse_binary_expression(
+    struct AstExpression *const out, 
+    struct Parser *const parser,
+    usize const min_precedence
+) {
+    parser_push_position(parser);
 
-    struct ParseResult const bracketed_expression_result = parse_bracketed_expression(out, parser);
-    if (bracketed_expression_result.ok) {
-        return parser_success(parser, &out->position);
-    }
+    struct TokenPosition const position_start 
+        = parserframesmallvec_peek_back(&parser->frame_stack)->position_start;
 
-    return parser_fail(
+    PARSER_FAIL_ON(
         parser,
-        join_parse_errors(
-            parser->ast_arena, 
-            4u, 
-            call_result.error,
-            identifier_result.error,
-            constant_result.error,
-            bracketed_expression_result.error
-        )
-    );
-}
+        parse_primary_expression(out, parser)
+    )
 
-// multiplicative_expression = primary_expression `*` primary_expression | primary_expression
-static struct ParseResult parse_multiplicative_expression(
-    struct AstExpression *const out, 
-    struct Parser *const parser
-) {
-    enum AstBinaryOpKind const ops[] = { AstBinaryOpMultiplication, AstBinaryOpDivision };
-    enum TokenKind const tokens[] = { TokenAsterisk, TokenSlash };
+    for (;;) {
+        struct BinaryOperator const op = binary_operators[parser_peek_kind(parser)];
 
-    return parse_binary_operation(
-        out, 
-        parser, 
-        2u,
-        ops, 
-        tokens, 
-        parse_multiplicative_expression, 
-        parse_primary_expression
-    );
-}
+        if (op.precedence == 0u || op.precedence < min_precedence) {
+            break;
+        }
 
-// additive_expression = additive_expression `+` additive_expression | additive_expression
-static struct ParseResult parse_additive_expression(
-    struct AstExpression *const out, 
-    struct Parser *const parser
-) {
-    enum AstBinaryOpKind const ops[] = { AstBinaryOpAddition, AstBinaryOpSubtraction };
-    enum TokenKind const tokens[] = { TokenPlus, TokenMinus };
+        parser_next(parser);
 
-    return parse_binary_operation(
-        out, 
-        parser, 
-        2u,
-        ops, 
-        tokens, 
-        parse_additive_expression, 
-        parse_multiplicative_expression
-    );
+        struct AstExpression right;
+        PARSER_FAIL_ON(
+            parser,
+            parse_binary_expression(&right, parser, op.precedence + 1u)
+        )
+
+        struct AstExpression const left = *out;
+        struct AstNodePosition const position = {
+            .position_start = position_start,
+            .position_end = parser->last_token.position,
+        };
+
+        *out = (struct AstExpression) {
+            .kind = AstExpressionBinaryOp,
+            .position = position,
+            .variant.binary_op = (struct AstBinaryOp) {
+                .kind = op.op,
+                .position = position,
+                .left = arena_copy(parser->ast_arena, &left, sizeof left),
+                .right = arena_copy(parser->ast_arena, &right, sizeof right),
+            },
+        };
+    }
+
+    return parser_success(parser, &out->position);
 }
 
 // assignee = identifier
@@ -467,35 +707,35 @@ static struct ParseResult parse_assignment(
     return parser_success(parser, &out->position);
 }
 
-// expression = assignment | sum
-static struct ParseResult parse_expression(
+// expression = assignment | binary_expression
+// an identifier followed by `=` starts an assignment
+static struct ParseResult parse_expression_uncached(
     struct AstExpression *const out, 
     struct Parser *const parser
 ) {
     parser_push_position(parser);
 
-    struct ParseResult const assignment_result = parse_assignment(out, parser);
-    if (assignment_result.ok) {
-        return parser_success(parser, &out->position);
-    }
+    bool const is_assignment 
+        = parser_peek_kind(parser) == TokenIdentifier 
+        && parser_peek_kind_nth(parser, 1u) == TokenEquals;
 
-    struct ParseResult const additive_result = parse_additive_expression(out, parser);
-    if (additive_result.ok) {
-        return parser_success(parser, &out->position);
+    if (is_assignment) {
+        PARSER_FAIL_ON(
+            parser,
+            parse_assignment(out, parser)
+        )
+    } else {
+        PARSER_FAIL_ON(
+            parser,
+            parse_binary_expression(out, parser, 1u)
+        )
     }
 
-    return parser_fail(
-        parser,
-        join_parse_errors(
-            parser->ast_arena, 
-            3u,
-            additive_result.error,
-            additive_result.error,
-            assignment_result.error
-        )
-    );
+    return parser_success(parser, &out->position);
 }
 
+PARSER_MEMOIZE(parse_expression, struct AstExpression, ParseRuleExpression)
+
 static struct ParseResult parse_integer_type(
     struct AstIntegerType *const out,
     struct Parser *const parser
@@ -512,6 +752,8 @@ static struct ParseResult parse_integer_type(
     bool is_signed = false;
     bool is_unsigned = false;
 
+    usize const start_position = parser_position(parser);
+
     for (;;) {
         if (parser_accept(parser, TokenKeywordInt)) {
             if (is_int) {
@@ -551,15 +793,20 @@ static struct ParseResult parse_integer_type(
         is_ok = false;
     }
     if (!is_ok) {
-        return parser_fail(
-            parser, 
-            (struct ParseError) {
-                .kind = ParseErrorInvalidIntegerType,
-                .variant.invalid_integer_type = {
-                    .position = parser->last_token.position,
-                }
-            }
-        );
+        if (parser_position(parser) == start_position) {
+            // not a type at all
+            parser_record_expected(parser, TokenKeywordInt);
+            parser_record_expected(parser, TokenKeywordLong);
+            parser_record_expected(parser, TokenKeywordShort);
+            parser_record_expected(parser, TokenKeywordChar);
+            parser_record_expected(parser, TokenKeywordSigned);
+            parser_record_expected(parser, TokenKeywordUnsigned);
+        } else if (parser_reach_failure(parser)) {
+            // the offending keyword is the last one consumed
+            parser->furthest_failure.is_invalid_integer_type = true;
+            parser->furthest_failure.invalid_integer_type_position = parser->last_token.position;
+        }
+        return parser_fail(parser);
     };
 
     if (is_char) {
@@ -592,7 +839,7 @@ static struct ParseResult parse_type(
         return parser_success(parser, &out->position);
     }
 
-    return parser_fail(parser, integer_result.error);
+    return parser_fail(parser);
 }
 
 // variable_declaration = type identifier `;` | type identifier `=` expression `;`
@@ -703,16 +950,7 @@ static struct ParseResult parse_statement(
         return parser_success(parser, &out->position);
     }
 
-    return parser_fail(
-        parser,
-        join_parse_errors(
-            parser->ast_arena, 
-            3u,
-            expression_result.error,
-            variable_declaration_result.error,
-            expression_result.error
-        )
-    );
+    return parser_fail(parser);
 }
 
 // statement_list = e | statement | statement_list statement
@@ -730,6 +968,8 @@ static struct ParseResult parse_block(struct AstBlock *const out, struct Parser
     arenavec_init(&statements, parser->ast_arena, sizeof (struct AstStatement));
 
     while (!parser_accept(parser, TokenRightBrace)) {
+        parser_record_expected(parser, TokenRightBrace);
+
         struct AstStatement statement;
         PARSER_FAIL_ON(
             parser,
@@ -737,6 +977,7 @@ static struct ParseResult parse_block(struct AstBlock *const out, struct Parser
         )
 
         arenavec_push(&statements, &statement);
+        parser_commit(parser);
     }
 
     out->statements = statements.data;
@@ -861,7 +1102,7 @@ static struct ParseResult parse_top_level_item(
         return parser_success(parser, &out->position);
     }
 
-    return parser_fail(parser, function_definition_result.error);
+    return parser_fail(parser);
 }
 
 // root = top_level_item | root top_level_item
@@ -872,12 +1113,15 @@ static struct ParseResult parse_root(struct AstRoot *const out, struct Parser *c
     arenavec_init(&top_level_items, parser->ast_arena, sizeof (struct AstTopLevelItem));
 
     while (!parser_accept(parser, TokenEof)) {
+        parser_record_expected(parser, TokenEof);
+
         struct AstTopLevelItem top_level_item;
         PARSER_FAIL_ON(
             parser, 
             parse_top_level_item(&top_level_item, parser)
         )
         arenavec_push(&top_level_items, &top_level_item);
+        parser_commit(parser);
     }
 
     out->items = top_level_items.data;
@@ -887,10 +1131,47 @@ static struct ParseResult parse_root(struct AstRoot *const out, struct Parser *c
     return parser_success(parser, &node_position_unused);
 }
 
-struct ParseResult parse(struct AstRoot *out, struct TokenSlice tokens, struct Arena *ast_arena) {
+// builds the error reported for a failed parse from the furthest failure
+static struct ParseError parser_build_error(struct Parser const *const self) {
+    struct ParseFailure const *const failure = &self->furthest_failure;
+
+    if (failure->is_invalid_integer_type) {
+        return (struct ParseError) {
+            .kind = ParseErrorInvalidIntegerType,
+            .variant.invalid_integer_type = {
+                .position = failure->invalid_integer_type_position,
+            },
+        };
+    }
+
+    return (struct ParseError) {
+        .kind = ParseErrorExpectedToken,
+        .variant.expected_token = {
+            .position = token_stream_position_at(self->tokens, failure->position),
+            .expected = failure->expected,
+            .got = token_stream_kind_at(self->tokens, failure->position),
+        },
+    };
+}
+
+struct ParseResult parse(
+    struct AstRoot *out, 
+    struct TokenStream *tokens, 
+    struct Arena *ast_arena,
+    struct ParseStatistics *statistics_out
+) {
     struct Parser parser;
     parser_init(&parser, tokens, ast_arena);
-    struct ParseResult const result = parse_root(out, &parser);
+    struct ParseResult result = parse_root(out, &parser);
+
+    if (!result.ok) {
+        result.error = parser_build_error(&parser);
+    }
+
+    if (statistics_out != NULL) {
+        *statistics_out = parser.statistics;
+    }
+
     parser_free(&parser);
 
     return result;
@@ -898,19 +1179,31 @@ struct ParseResult parse(struct AstRoot *out, struct TokenSlice tokens, struct A
 
 void format_parse_error(
     struct Writer *const writer, 
+    struct SourceMap *const sources,
     struct ParseError const *const error
 ) {
     switch (error->kind) {
         case ParseErrorExpectedToken: {
-            writer_writef(
-                writer, 
-                "(%zu:%zu) expected ", 
-                error->variant.expected_token.position.line, 
-                error->variant.expected_token.position.character
-            );
-            writer_write(writer, color_magenta);
-            token_kind_debug(writer, &error->variant.expected_token.expected);
-            writer_write(writer, color_reset);
+            struct SourceLineColumn const location 
+                = source_map_line_column(sources, error->variant.expected_token.position);
+
+            writer_writef(writer, "(%zu:%zu) expected ", location.line, location.column);
+
+            bool is_first = true;
+            for (usize kind = 0u; kind < TokenCount; kind += 1u) {
+                if ((error->variant.expected_token.expected & ((u64) 1u << kind)) == 0u) {
+                    continue;
+                }
+                if (!is_first) {
+                    writer_writef(writer, " %sOR%s ", color_green, color_reset);
+                }
+                is_first = false;
+
+                enum TokenKind const expected = (enum TokenKind) kind;
+                writer_write(writer, color_magenta);
+                token_kind_debug(writer, &expected);
+                writer_write(writer, color_reset);
+            }
 
             writer_write(writer, ", got ");
             writer_write(writer, color_magenta);
@@ -919,19 +1212,11 @@ void format_parse_error(
 
             break;
         }
-        case ParseErrorJoin: {
-            format_parse_error(writer, error->variant.join.left);
-            writer_writef(writer, " %sOR%s ", color_green, color_reset);
-            format_parse_error(writer, error->variant.join.right);
-            break;
-        }
         case ParseErrorInvalidIntegerType: {
-            writer_writef(
-                writer, 
-                "(%zu:%zu) invalid integer type",
-                error->variant.invalid_integer_type.position.line,
-                error->variant.invalid_integer_type.position.character
-            );
+            struct SourceLineColumn const location 
+                = source_map_line_column(sources, error->variant.invalid_integer_type.position);
+
+            writer_writef(writer, "(%zu:%zu) invalid integer type", location.line, location.column);
             break;
         }
         default: {
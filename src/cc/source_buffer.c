@@ -0,0 +1,155 @@
+#include "cc/source_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the lexer's scanning kernels read whole aligned blocks, so heap buffers are padded with zeros 
+// to keep those reads inside the allocation
+#define SOURCE_BUFFER_PADDING 64u
+#define SOURCE_BUFFER_INITIAL_CAPACITY 4096u
+
+static bool source_buffer_map(struct SourceBuffer *const out, i32 const fd, usize const len) {
+    usize const page_size = (usize) sysconf(_SC_PAGESIZE);
+    // always leave room for at least one zero byte after the file
+    usize const capacity = round_up_usize(len + 1u, page_size);
+
+    // reserve the whole range as zero pages, then map the file over the start of it. The bytes 
+    // of the last file page past the end of the file are zero too, so the source is always 
+    // followed by a NUL
+    void *const reservation = mmap(
+        NULL, 
+        capacity, 
+        PROT_READ, 
+        MAP_PRIVATE | MAP_ANONYMOUS, 
+        -1, 
+        0
+    );
+    if (reservation == MAP_FAILED) {
+        return false;
+    }
+
+    void *const mapping = mmap(reservation, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        i32 const error = errno;
+        munmap(reservation, capacity);
+        errno = error;
+        return false;
+    }
+
+    // advisory only, the source is lexed front to back
+    madvise(mapping, len, MADV_SEQUENTIAL);
+
+    *out = (struct SourceBuffer) {
+        .kind = SourceBufferKindMapped,
+        .data = mapping,
+        .len = len,
+        .capacity = capacity,
+    };
+    return true;
+}
+
+static bool source_buffer_read(struct SourceBuffer *const out, FILE *const f) {
+    usize capacity = SOURCE_BUFFER_INITIAL_CAPACITY;
+    usize len = 0u;
+
+    char *buffer = malloc(capacity);
+    if (buffer == NULL) {
+        return false;
+    }
+
+    for (;;) {
+        if (capacity - len <= SOURCE_BUFFER_PADDING) {
+            capacity *= 2u;
+
+            char *const new_buffer = realloc(buffer, capacity);
+            if (new_buffer == NULL) {
+                free(buffer);
+                return false;
+            }
+            buffer = new_buffer;
+        }
+
+        usize const request_len = capacity - len - SOURCE_BUFFER_PADDING;
+        usize const read_len = fread(buffer + len, 1u, request_len, f);
+        len += read_len;
+
+        if (read_len < request_len) {
+            // end of file or an error
+            if (ferror(f)) {
+                i32 const error = errno;
+                free(buffer);
+                errno = error;
+                return false;
+            }
+            break;
+        }
+    }
+
+    memset(buffer + len, 0, SOURCE_BUFFER_PADDING);
+
+    *out = (struct SourceBuffer) {
+        .kind = SourceBufferKindHeap,
+        .data = buffer,
+        .len = len,
+        .capacity = capacity,
+    };
+    return true;
+}
+
+bool source_buffer_open(struct SourceBuffer *const out, char const *const path) {
+    if (strcmp(path, "-") == 0) {
+        return source_buffer_read(out, stdin);
+    }
+
+    FILE *const f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+
+    struct stat file_stat;
+    bool ok;
+
+    if (fstat(fileno(f), &file_stat) == 0 
+        && S_ISREG(file_stat.st_mode) 
+        && file_stat.st_size > 0 
+        && (u64) file_stat.st_size < (u64) SIZE_MAX
+    ) {
+        ok = source_buffer_map(out, fileno(f), (usize) file_stat.st_size);
+
+        if (!ok) {
+            // e.g. a filesystem that does not support mmap
+            ok = source_buffer_read(out, f);
+        }
+    } else {
+        ok = source_buffer_read(out, f);
+    }
+
+    i32 const error = errno;
+    fclose(f);
+    errno = error;
+
+    return ok;
+}
+
+void source_buffer_free(struct SourceBuffer *const self) {
+    switch (self->kind) {
+        case SourceBufferKindMapped: {
+            munmap((void *) self->data, self->capacity);
+            break;
+        }
+        case SourceBufferKindHeap: {
+            free((void *) self->data);
+            break;
+        }
+    }
+
+    self->data = NULL;
+    self->len = 0u;
+    self->capacity = 0u;
+}
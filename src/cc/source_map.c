@@ -0,0 +1,115 @@
+#include "cc/source_map.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cc/log.h"
+
+static void source_file_build_line_starts(struct SourceFile *const self) {
+    char const *const source = self->buffer.data;
+    usize const len = self->buffer.len;
+
+    usize capacity = 64u;
+    self->line_starts = malloc(sizeof *self->line_starts * capacity);
+    self->line_starts[0] = 0u;
+    self->line_count = 1u;
+
+    char const *newline = memchr(source, '\n', len);
+
+    while (newline != NULL) {
+        if (self->line_count == capacity) {
+            capacity *= 2u;
+            self->line_starts = realloc(self->line_starts, sizeof *self->line_starts * capacity);
+        }
+
+        usize const line_start = (usize) (newline - source) + 1u;
+        self->line_starts[self->line_count] = (u32) line_start;
+        self->line_count += 1u;
+
+        newline = memchr(source + line_start, '\n', len - line_start);
+    }
+}
+
+void source_map_init(struct SourceMap *const self) {
+    self->files = NULL;
+    self->file_count = 0u;
+}
+
+void source_map_free(struct SourceMap *const self) {
+    for (usize file = 0u; file < self->file_count; file += 1u) {
+        source_buffer_free(&self->files[file].buffer);
+        free(self->files[file].line_starts);
+    }
+
+    free(self->files);
+}
+
+bool source_map_add_file(struct SourceMap *const self, char const *const path, u32 *const file_out) {
+    struct SourceBuffer buffer;
+
+    if (!source_buffer_open(&buffer, path)) {
+        return false;
+    }
+
+    // offsets are 32-bit, and the end of file needs one too
+    if (buffer.len >= UINT32_MAX) {
+        source_buffer_free(&buffer);
+        errno = EFBIG;
+        return false;
+    }
+
+    self->files = realloc(self->files, sizeof *self->files * (self->file_count + 1u));
+    self->files[self->file_count] = (struct SourceFile) {
+        .path = path,
+        .buffer = buffer,
+        .line_starts = NULL,
+        .line_count = 0u,
+    };
+
+    *file_out = (u32) self->file_count;
+    self->file_count += 1u;
+
+    return true;
+}
+
+struct SourceFile const *source_map_file(struct SourceMap const *const self, u32 const file) {
+    if (file >= self->file_count) {
+        log_error("source_map_file: no file %u (file count = %zu)", file, self->file_count);
+        exit(1);
+    }
+
+    return &self->files[file];
+}
+
+struct SourceLineColumn source_map_line_column(
+    struct SourceMap *const self, 
+    struct TokenPosition const position
+) {
+    // (bounds checked)
+    source_map_file(self, position.file);
+    struct SourceFile *const file = &self->files[position.file];
+
+    if (file->line_starts == NULL) {
+        source_file_build_line_starts(file);
+    }
+
+    // binary search for the last line starting at or before the offset
+    usize low = 0u;
+    usize high = file->line_count;
+
+    while (high - low > 1u) {
+        usize const middle = low + (high - low) / 2u;
+
+        if (file->line_starts[middle] <= position.offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return (struct SourceLineColumn) {
+        .line = low + 1u,
+        .column = (usize) (position.offset - file->line_starts[low]) + 1u,
+    };
+}
@@ -3,58 +3,62 @@
 #include "cc/slice.h"
 #include "cc/writer.h"
 
-void token_kind_debug(struct Writer *writer, enum TokenKind const *kind) {
-    char const *const token_names[] = {
-        "<unknown>",
-        // misc
-        "<eof>",
-        ";",
-        "(",
-        ")",
-        "{",
-        "}",
-        "[",
-        "]",
-        ",",
-        // operators
-        "=",
-        "==",
-        "+",
-        "-",
-        "*",
-        "/",
-        // keywords
-        "return",
-        "if",
-        "else",
-        "do",
-        "while",
-        "for",
-        "switch",
-        "continue",
-        "break",
-        "const",
-        "void",
-        "int",
-        "signed",
-        "unsigned",
-        "long",
-        "short",
-        "char",
-        "float",
-        "double",
-        // variable tokens
-        "<identifier>",
-        "<integer>"
-    };
+static char const *const token_names[TokenCount] = {
+    "<unknown>",
+    // misc
+    "<eof>",
+    ";",
+    "(",
+    ")",
+    "{",
+    "}",
+    "[",
+    "]",
+    ",",
+    // operators
+    "=",
+    "==",
+    "+",
+    "-",
+    "*",
+    "/",
+    // keywords
+    "return",
+    "if",
+    "else",
+    "do",
+    "while",
+    "for",
+    "switch",
+    "continue",
+    "break",
+    "const",
+    "void",
+    "int",
+    "signed",
+    "unsigned",
+    "long",
+    "short",
+    "char",
+    "float",
+    "double",
+    // variable tokens
+    "<identifier>",
+    "<integer>"
+};
 
-    if (*kind < TokenCount) {
-        writer_write(writer, token_names[*kind]);
+char const *token_kind_name(enum TokenKind const kind) {
+    if (kind < TokenCount) {
+        return token_names[kind];
     } else {
-        writer_write(writer, "<unknown>");
+        return "<unknown>";
     }
 }
 
+void token_kind_debug(struct Writer *writer, enum TokenKind const *kind) {
+    writer_write(writer, token_kind_name(*kind));
+}
+
 void token_debug(struct Writer *writer, struct Token const *token) {
     switch (token->kind) {
         case TokenIdentifier: {
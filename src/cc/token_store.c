@@ -0,0 +1,177 @@
+#include "cc/token_store.h"
+
+#include <stdlib.h>
+
+#include "cc/log.h"
+#include "cc/token.h"
+
+// must be powers of 2
+#define TOKEN_STORE_INITIAL_CAPACITY 64u
+#define TOKEN_STORE_INITIAL_INTEGER_CAPACITY 16u
+
+// double the token ring capacity, keeping every held token at its masked index
+static void token_store_grow(struct TokenStore *const self) {
+    usize const old_mask = self->capacity - 1u;
+    usize const new_capacity = self->capacity * 2u;
+    usize const new_mask = new_capacity - 1u;
+
+    u8 *const kinds = malloc(sizeof *kinds * new_capacity);
+    u32 *const offsets = malloc(sizeof *offsets * new_capacity);
+    u32 *const payloads = malloc(sizeof *payloads * new_capacity);
+
+    for (usize position = self->released; position < self->len; position += 1u) {
+        kinds[position & new_mask] = self->kinds[position & old_mask];
+        offsets[position & new_mask] = self->offsets[position & old_mask];
+        payloads[position & new_mask] = self->payloads[position & old_mask];
+    }
+
+    free(self->kinds);
+    free(self->offsets);
+    free(self->payloads);
+
+    self->kinds = kinds;
+    self->offsets = offsets;
+    self->payloads = payloads;
+    self->capacity = new_capacity;
+}
+
+// double the integer ring capacity, keeping every held literal at its masked index
+static void token_store_grow_integers(struct TokenStore *const self) {
+    usize const old_mask = self->integer_capacity - 1u;
+    usize const new_capacity = self->integer_capacity * 2u;
+    usize const new_mask = new_capacity - 1u;
+
+    struct TokenStoreInteger *const integers = malloc(sizeof *integers * new_capacity);
+
+    for (usize index = self->integers_released; index < self->integer_count; index += 1u) {
+        integers[index & new_mask] = self->integers[index & old_mask];
+    }
+
+    free(self->integers);
+    self->integers = integers;
+    self->integer_capacity = new_capacity;
+}
+
+void token_store_init(
+    struct TokenStore *const self, 
+    char const *const source_string, 
+    u32 const file,
+    struct Interner const *const interner
+) {
+    self->source_string = source_string;
+    self->file = file;
+    self->interner = interner;
+
+    self->kinds = malloc(sizeof *self->kinds * TOKEN_STORE_INITIAL_CAPACITY);
+    self->offsets = malloc(sizeof *self->offsets * TOKEN_STORE_INITIAL_CAPACITY);
+    self->payloads = malloc(sizeof *self->payloads * TOKEN_STORE_INITIAL_CAPACITY);
+    self->capacity = TOKEN_STORE_INITIAL_CAPACITY;
+    self->released = 0u;
+    self->len = 0u;
+
+    self->integers = malloc(sizeof *self->integers * TOKEN_STORE_INITIAL_INTEGER_CAPACITY);
+    self->integer_capacity = TOKEN_STORE_INITIAL_INTEGER_CAPACITY;
+    self->integers_released = 0u;
+    self->integer_count = 0u;
+}
+
+void token_store_free(struct TokenStore *const self) {
+    free(self->kinds);
+    free(self->offsets);
+    free(self->payloads);
+    free(self->integers);
+}
+
+void token_store_push(struct TokenStore *const self, struct Token const *const token) {
+    if (self->len - self->released == self->capacity) {
+        token_store_grow(self);
+    }
+
+    u32 payload = 0u;
+
+    if (token->kind == TokenIdentifier) {
+        payload = token->variant.identifier.symbol;
+    } else if (token->kind == TokenInteger) {
+        if (self->integer_count - self->integers_released == self->integer_capacity) {
+            token_store_grow_integers(self);
+        }
+
+        self->integers[self->integer_count & (self->integer_capacity - 1u)] 
+            = (struct TokenStoreInteger) {
+                .value = token->variant.integer.value,
+                .position = (u32) self->len,
+                .is_long = token->variant.integer.is_long,
+                .is_signed = token->variant.integer.is_signed,
+            };
+        // only the masked bits are used, so wrapping is harmless
+        payload = (u32) self->integer_count;
+        self->integer_count += 1u;
+    }
+
+    usize const index = self->len & (self->capacity - 1u);
+    self->kinds[index] = (u8) token->kind;
+    self->offsets[index] = token->position.offset;
+    self->payloads[index] = payload;
+    self->len += 1u;
+
+}
+
+void token_store_release(struct TokenStore *const self, usize const position) {
+    if (position <= self->released) {
+        return;
+    }
+
+    // never release tokens that have not been pushed yet
+    self->released = position < self->len ? position : self->len;
+
+    while (
+        self->integers_released < self->integer_count
+        && self->integers[self->integers_released & (self->integer_capacity - 1u)].position 
+            < (u32) self->released
+    ) {
+        self->integers_released += 1u;
+    }
+}
+
+struct Token token_store_get(struct TokenStore *const self, usize const position) {
+    if (position < self->released || position >= self->len) {
+        log_error(
+            "token_store_get: token %zu is not held (held = [%zu, %zu))", 
+            position, 
+            self->released, 
+            self->len
+        );
+        exit(1);
+    }
+
+    usize const index = position & (self->capacity - 1u);
+
+    struct Token token = {
+        .kind = (enum TokenKind) self->kinds[index],
+        .position = token_store_position(self, position),
+    };
+
+    u32 const payload = self->payloads[index];
+
+    if (token.kind == TokenIdentifier) {
+        token.variant.identifier.symbol = payload;
+        token.variant.identifier.name = (struct CharSlice) {
+            .ptr = (char *) self->source_string + self->offsets[index],
+            .len = interner_name(self->interner, payload).len,
+        };
+    } else if (token.kind == TokenInteger) {
+        struct TokenStoreInteger const integer 
+            = self->integers[payload & (self->integer_capacity - 1u)];
+
+        token.variant.integer.value = integer.value;
+        token.variant.integer.is_long = integer.is_long;
+        token.variant.integer.is_signed = integer.is_signed;
+    }
+
+    return token;
+}
+
+usize token_store_memory_usage(struct TokenStore const *const self) {
+    return self->capacity * (sizeof *self->kinds + sizeof *self->offsets + sizeof *self->payloads)
+        + self->integer_capacity * sizeof *self->integers;
+}
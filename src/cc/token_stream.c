@@ -0,0 +1,120 @@
+#include "cc/token_stream.h"
+
+#include <stdlib.h>
+
+#include "cc/lexer.h"
+#include "cc/log.h"
+#include "cc/token.h"
+#include "cc/token_store.h"
+
+static struct TokenStore *token_stream_tokens(struct TokenStream *const self) {
+    switch (self->kind) {
+        case TokenStreamKindStore: {
+            return self->variant.store.tokens;
+        }
+        case TokenStreamKindLexer: {
+            return &self->variant.lexer.tokens;
+        }
+    }
+
+    log_error("token_stream_tokens: unknown token stream kind %zu", (usize) self->kind);
+    exit(1);
+}
+
+// lex one more token into the store
+static void token_stream_lex_next(struct TokenStream *const self) {
+    struct Token const token = lexer_next_token(&self->variant.lexer.lexer);
+
+    token_store_push(&self->variant.lexer.tokens, &token);
+    self->variant.lexer.reached_eof = token.kind == TokenEof;
+}
+
+// make sure the token at `position` is in the store if the stream has one, returns false past 
+// the end of the stream
+static bool token_stream_fill(struct TokenStream *const self, usize const position) {
+    struct TokenStore *const tokens = token_stream_tokens(self);
+
+    if (position < tokens->released) {
+        log_error(
+            "token_stream: token %zu was already released (released = %zu)", 
+            position, 
+            tokens->released
+        );
+        exit(1);
+    }
+
+    if (self->kind == TokenStreamKindLexer) {
+        while (position >= tokens->len && !self->variant.lexer.reached_eof) {
+            token_stream_lex_next(self);
+        }
+    }
+
+    return position < tokens->len;
+}
+
+void token_stream_init_store(struct TokenStream *const self, struct TokenStore *const tokens) {
+    self->kind = TokenStreamKindStore;
+    self->variant.store.tokens = tokens;
+}
+
+void token_stream_init_lexer(
+    struct TokenStream *const self, 
+    char const *const source_string, 
+    u32 const file,
+    struct Interner *const interner
+) {
+    self->kind = TokenStreamKindLexer;
+
+    lexer_init(&self->variant.lexer.lexer, source_string, file, interner);
+    token_store_init(&self->variant.lexer.tokens, source_string, file, interner);
+    self->variant.lexer.reached_eof = false;
+}
+
+void token_stream_free(struct TokenStream *const self) {
+    switch (self->kind) {
+        case TokenStreamKindStore: {
+            break;
+        }
+        case TokenStreamKindLexer: {
+            token_store_free(&self->variant.lexer.tokens);
+            break;
+        }
+    }
+}
+
+enum TokenKind token_stream_kind_at(struct TokenStream *const self, usize const position) {
+    if (token_stream_fill(self, position)) {
+        return token_store_kind(token_stream_tokens(self), position);
+    } else {
+        return TokenUnknown;
+    }
+}
+
+struct TokenPosition token_stream_position_at(struct TokenStream *const self, usize const position) {
+    struct TokenStore const *const tokens = token_stream_tokens(self);
+
+    if (token_stream_fill(self, position)) {
+        return token_store_position(tokens, position);
+    } else if (tokens->len > tokens->released) {
+        // the last token is the end of file
+        return token_store_position(tokens, tokens->len - 1u);
+    } else {
+        return (struct TokenPosition) { .file = tokens->file, .offset = 0u };
+    }
+}
+
+struct Token token_stream_at(struct TokenStream *const self, usize const position) {
+    if (token_stream_fill(self, position)) {
+        return token_store_get(token_stream_tokens(self), position);
+    } else {
+        return (struct Token) { .kind = TokenUnknown };
+    }
+}
+
+void token_stream_release(struct TokenStream *const self, usize const position) {
+    if (self->kind != TokenStreamKindLexer) {
+        return;
+    }
+
+    token_store_release(&self->variant.lexer.tokens, position);
+}
@@ -4,11 +4,13 @@
 #define VEC_TYPE CharVec 
 #define VEC_SLICE_TYPE CharSlice 
 #define VEC_FUNCTION_PREFIX charvec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.inl"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
 
 #define VEC_ELEMENT_TYPE void* 
@@ -26,9 +28,11 @@
 #define VEC_TYPE UsizeVec 
 #define VEC_SLICE_TYPE UsizeSlice
 #define VEC_FUNCTION_PREFIX usizevec_
+#define VEC_ALLOCATOR
 #include "cc/template/vec.inl"
 #undef VEC_ELEMENT_TYPE
 #undef VEC_TYPE
 #undef VEC_SLICE_TYPE
 #undef VEC_FUNCTION_PREFIX
+#undef VEC_ALLOCATOR
 
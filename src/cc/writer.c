@@ -3,14 +3,31 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "cc/chunk_list.h"
+#include "cc/log.h"
 #include "cc/slice.h"
 #include "cc/vec.h"
 
+#define WRITER_FILE_BUFFER_LEN (64u * 1024u)
+// space made for a formatted write before its length is known, most fit without a retry
+#define WRITER_FORMAT_MIN_SPACE 128u
+
 struct Writer file_writer(FILE *const file) {
+    char *const buffer = malloc(WRITER_FILE_BUFFER_LEN);
+    if (buffer == NULL) {
+        log_error("file_writer: cannot allocate buffer");
+        exit(1);
+    }
+
     return (struct Writer) {
         .kind = WriterKindFile,
-        .variant.file = { .file = file },
+        .variant.file = { 
+            .file = file,
+            .buffer = buffer,
+            .len = 0u,
+        },
     };
 }
 
@@ -21,64 +38,258 @@ struct Writer charvec_writer(struct CharVec *const buffer) {
     };
 }
 
-void writer_write(
-    struct Writer const *const self,
-    char const *const string
-) {
+struct Writer chunk_list_writer(struct ChunkList *const chunks) {
+    return (struct Writer) {
+        .kind = WriterKindChunkList,
+        .variant.chunk_list = { .chunks = chunks },
+    };
+}
+
+void writer_free(struct Writer *const self) {
+    writer_flush(self);
+
+    if (self->kind == WriterKindFile) {
+        free(self->variant.file.buffer);
+        self->variant.file.buffer = NULL;
+    }
+}
+
+void writer_flush(struct Writer *const self) {
+    switch (self->kind) {
+        case WriterKindFile: {
+            fwrite(self->variant.file.buffer, sizeof (char), self->variant.file.len, self->variant.file.file);
+            fflush(self->variant.file.file);
+            self->variant.file.len = 0u;
+            break;
+        }
+
+        case WriterKindCharVec:
+        case WriterKindChunkList: {
+            break;
+        }
+    }
+}
+
+// spare space of at least `min_len` bytes to write to, and its length in `available_out`
+// returns NULL if a file writer's buffer or a chunk is smaller than `min_len`
+static char *writer_space(struct Writer *const self, usize const min_len, usize *const available_out) {
     switch (self->kind) {
         case WriterKindFile: {
-            fputs(string, self->variant.file.file);
+            if (WRITER_FILE_BUFFER_LEN - self->variant.file.len < min_len) {
+                writer_flush(self);
+            }
+            if (WRITER_FILE_BUFFER_LEN < min_len) {
+                return NULL;
+            }
+
+            *available_out = WRITER_FILE_BUFFER_LEN - self->variant.file.len;
+            return self->variant.file.buffer + self->variant.file.len;
+        }
+
+        case WriterKindCharVec: {
+            struct CharVec *const buffer = self->variant.charvec.buffer;
+            charvec_reserve(buffer, min_len);
+
+            *available_out = buffer->capacity - buffer->len;
+            return buffer->data + buffer->len;
+        }
+
+        case WriterKindChunkList: {
+            return chunk_list_space(self->variant.chunk_list.chunks, min_len, available_out);
+        }
+    }
+
+    log_error("writer_space: unknown writer kind %zu", (usize) self->kind);
+    exit(1);
+}
+
+// marks `len` bytes of the space returned by `writer_space` as written
+static void writer_advance(struct Writer *const self, usize const len) {
+    switch (self->kind) {
+        case WriterKindFile: {
+            self->variant.file.len += len;
             break;
         }
 
         case WriterKindCharVec: {
-            charvec_push_slice(
-                self->variant.charvec.buffer, 
-                charslice_from_cstr(string)
-            );
+            self->variant.charvec.buffer->len += len;
             break;
         }
+
+        case WriterKindChunkList: {
+            chunk_list_advance(self->variant.chunk_list.chunks, len);
+            break;
+        }
+    }
+}
+
+void writer_write_bytes(struct Writer *const self, char const *const bytes, usize const len) {
+    if (len == 0u) {
+        return;
+    }
+
+    usize available;
+    char *const space = writer_space(self, len, &available);
+
+    if (space != NULL) {
+        memcpy(space, bytes, len);
+        writer_advance(self, len);
+        return;
+    }
+
+    // larger than a file buffer or a chunk, so fill them up one after the other
+    usize written = 0u;
+    while (written < len) {
+        char *const piece = writer_space(self, 1u, &available);
+        usize const piece_len = min_usize(len - written, available);
+
+        memcpy(piece, bytes + written, piece_len);
+        writer_advance(self, piece_len);
+        written += piece_len;
+    }
+}
+
+void writer_write_char(struct Writer *const self, char const c) {
+    usize available;
+    char *const space = writer_space(self, 1u, &available);
+
+    *space = c;
+    writer_advance(self, 1u);
+}
+
+void writer_write_u64(struct Writer *const self, u64 value) {
+    // digits are produced from the least significant one, so fill the buffer from the end
+    char digits[20];
+    usize start = sizeof (digits);
+
+    do {
+        start -= 1u;
+        digits[start] = (char) ('0' + value % 10u);
+        value /= 10u;
+    } while (value != 0u);
+
+    writer_write_bytes(self, digits + start, sizeof (digits) - start);
+}
+
+void writer_write_i64(struct Writer *const self, i64 const value) {
+    if (value < 0) {
+        writer_write_char(self, '-');
+        // negate as unsigned, which is defined for the most negative value too
+        writer_write_u64(self, -(u64) value);
+    } else {
+        writer_write_u64(self, (u64) value);
     }
 }
 
 void writer_writef(
-    struct Writer const *const self,
+    struct Writer *const self,
     char const *const format_string, 
     ...
 ) {
-    va_list args;
+    va_list args, args_retry;
     va_start(args, format_string);
+    va_copy(args_retry, args);
+
+    // format into the spare space, and if it does not fit, make enough room and format again
+    usize available;
+    char *space = writer_space(self, WRITER_FORMAT_MIN_SPACE, &available);
+    i32 const len = vsnprintf(space, available, format_string, args);
+
+    if (len < 0) {
+        log_error("writer_writef: invalid format string \"%s\"", format_string);
+        exit(1);
+    }
+
+    if ((usize) len >= available) {
+        // vsnprintf also writes a terminating null byte
+        space = writer_space(self, (usize) len + 1u, &available);
 
+        if (space == NULL) {
+            // larger than a file buffer or a chunk, so the only way is through the heap
+            char *const formatted = malloc((usize) len + 1u);
+            if (formatted == NULL) {
+                log_error("writer_writef: cannot allocate %zu bytes", (usize) len + 1u);
+                exit(1);
+            }
+            vsnprintf(formatted, (usize) len + 1u, format_string, args_retry);
+            writer_write_bytes(self, formatted, (usize) len);
+            free(formatted);
+        } else {
+            vsnprintf(space, available, format_string, args_retry);
+            writer_advance(self, (usize) len);
+        }
+    } else {
+        writer_advance(self, (usize) len);
+    }
+
+    va_end(args_retry);
+    va_end(args);
+}
+
+struct WriterPlaceholder writer_reserve(struct Writer *const self, usize const len) {
     switch (self->kind) {
         case WriterKindFile: {
-            vfprintf(self->variant.file.file, format_string, args);
             break;
         }
 
         case WriterKindCharVec: {
-            char *buf;
-            vasprintf(&buf, format_string, args);
-            charvec_push_slice(
-                self->variant.charvec.buffer, 
-                charslice_from_cstr(buf)
-            );
-            free(buf);
-            break;
+            struct CharVec *const buffer = self->variant.charvec.buffer;
+            charvec_reserve(buffer, len);
+
+            // the vec may move, so remember the offset rather than a pointer
+            struct WriterPlaceholder const placeholder = {
+                .kind = WriterKindCharVec,
+                .variant.charvec = {
+                    .offset = buffer->len,
+                    .len = len,
+                },
+            };
+            buffer->len += len;
+            return placeholder;
+        }
+
+        case WriterKindChunkList: {
+            return (struct WriterPlaceholder) {
+                .kind = WriterKindChunkList,
+                .variant.chunk_list = chunk_list_reserve(self->variant.chunk_list.chunks, len),
+            };
         }
     }
 
-    va_end(args);
+    log_error("writer_reserve: not supported by writer kind %zu", (usize) self->kind);
+    exit(1);
 }
 
-void writer_write_charslice(struct Writer const *self, struct CharSlice slice) {
+void writer_patch(
+    struct Writer *const self, 
+    struct WriterPlaceholder const placeholder, 
+    char const *const bytes
+) {
+    if (placeholder.kind != self->kind) {
+        log_error("writer_patch: placeholder belongs to another kind of writer");
+        exit(1);
+    }
+
     switch (self->kind) {
         case WriterKindFile: {
-            fputs(charslice_as_cstr(slice), self->variant.file.file);
             break;
         }
+
         case WriterKindCharVec: {
-            charvec_push_slice(self->variant.charvec.buffer, slice);
-            break;
+            memcpy(
+                self->variant.charvec.buffer->data + placeholder.variant.charvec.offset, 
+                bytes, 
+                placeholder.variant.charvec.len
+            );
+            return;
+        }
+
+        case WriterKindChunkList: {
+            chunk_list_patch(self->variant.chunk_list.chunks, placeholder.variant.chunk_list, bytes);
+            return;
         }
     }
+
+    log_error("writer_patch: not supported by writer kind %zu", (usize) self->kind);
+    exit(1);
 }
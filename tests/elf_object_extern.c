@@ -0,0 +1,80 @@
+#include <stdio.h>
+
+#include "cc/common.h"
+#include "cc/compile/assembly.h"
+#include "cc/compile/encoder.h"
+#include "cc/elf_object.h"
+#include "cc/slice.h"
+#include "cc/writer.h"
+
+// Writes an object whose main calls functions of libc, which the language cannot declare:
+//     main() { exit(abs(-40) + helper()); }
+//     helper() { return 2; }
+// so that linking it with ld exercises the undefined symbols and R_X86_64_PLT32 relocations
+// (the program exits with 42)
+
+i32 main(i32 const argc, char **const argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <object>\n", argv[0]);
+        return 1;
+    }
+
+    struct CodeBuffer text;
+    code_buffer_init(&text);
+    struct CodeBuffer data;
+    code_buffer_init(&data);
+
+    struct Emitter emitter = code_emitter(&text);
+
+    emit_label(&emitter, charslice_from_cstr("main"));
+    struct EmitterPlaceholder const prologue = emit_function_prologue(&emitter);
+    emit_instruction_dst_src(
+        &emitter, InstructionMov, DWord, DWord, operand_register(RegisterDI), operand_immediate((u64) -40)
+    );
+    emit_instruction_single_operand(&emitter, InstructionCall, QWord, operand_label(charslice_from_cstr("abs")));
+    emit_instruction_dst_src(&emitter, InstructionMov, QWord, QWord, operand_stack(8u), operand_register(RegisterA));
+    // a call to a later label in the same object is resolved by the encoder
+    emit_instruction_single_operand(&emitter, InstructionCall, QWord, operand_label(charslice_from_cstr("helper")));
+    emit_instruction_dst_src(&emitter, InstructionAdd, QWord, QWord, operand_register(RegisterA), operand_stack(8u));
+    emit_instruction_dst_src(
+        &emitter, InstructionMov, QWord, QWord, operand_register(RegisterDI), operand_register(RegisterA)
+    );
+    emit_instruction_single_operand(&emitter, InstructionCall, QWord, operand_label(charslice_from_cstr("exit")));
+    emit_function_exit(&emitter);
+    patch_function_prologue(&emitter, prologue, 8u);
+
+    emit_label(&emitter, charslice_from_cstr("helper"));
+    emit_instruction_dst_src(&emitter, InstructionMov, DWord, DWord, operand_register(RegisterA), operand_immediate(2u));
+    emit_instruction(&emitter, InstructionRet);
+
+    code_buffer_resolve_fixups(&text);
+
+    FILE *const object_file = fopen(argv[1], "wb");
+    if (object_file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    struct Writer object_writer = file_writer(object_file);
+    elf_write_object(
+        &object_writer,
+        &(struct ObjectSections) {
+            .text = &text,
+            .data = &data,
+            .rodata = NULL,
+            .bss_len = 0u,
+        }
+    );
+    writer_free(&object_writer);
+
+    bool const ok = ferror(object_file) == 0;
+    if (fclose(object_file) != 0 || !ok) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    code_buffer_free(&text);
+    code_buffer_free(&data);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+# Links an object file written by cc with the system ld and the C runtime, runs it, and checks its
+# exit code
+#
+#   cmake -DCC=<cc> -DC_COMPILER=<cc for the crt files> -DWORK_DIR=<dir> -DEXPECTED_EXIT=<code>
+#         (-DSOURCE=<file.c> | -DOBJECT_WRITER=<program>) -P object_link.cmake
+#
+# With SOURCE, the object is written by `cc --object`. The exit code must also match the
+# executable cc links itself, and the --asm build when nasm is installed.
+# With OBJECT_WRITER, the object is written by `<program> <object>` instead (for code the language
+# cannot express, such as calls to libc).
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/input ${WORK_DIR}/output)
+
+foreach(crt_file crt1.o crti.o crtn.o)
+    execute_process(
+        COMMAND ${C_COMPILER} -print-file-name=${crt_file}
+        OUTPUT_VARIABLE crt_path
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+    )
+    if(NOT EXISTS "${crt_path}")
+        message(FATAL_ERROR "could not find ${crt_file} (${C_COMPILER} -print-file-name=${crt_file})")
+    endif()
+    list(APPEND crt_paths ${crt_path})
+endforeach()
+list(GET crt_paths 0 crt1_path)
+get_filename_component(crt_dir ${crt1_path} DIRECTORY)
+
+# links `object` into `executable` with ld, runs it and stores its exit code in `exit_out`
+function(link_and_run object executable exit_out)
+    execute_process(
+        COMMAND ld -dynamic-linker /lib64/ld-linux-x86-64.so.2 -o ${executable} ${object} ${crt_paths}
+            -L${crt_dir} -lc
+        RESULT_VARIABLE link_result
+        ERROR_VARIABLE link_error
+    )
+    if(NOT link_result EQUAL 0)
+        message(FATAL_ERROR "ld failed for ${object}:\n${link_error}")
+    endif()
+
+    run(${executable} exit_code)
+    set(${exit_out} ${exit_code} PARENT_SCOPE)
+endfunction()
+
+function(run executable exit_out)
+    execute_process(COMMAND ${executable} RESULT_VARIABLE exit_code OUTPUT_QUIET)
+    set(${exit_out} ${exit_code} PARENT_SCOPE)
+endfunction()
+
+# runs cc with `arguments`, which must succeed
+function(run_cc)
+    execute_process(
+        COMMAND ${CC} ${ARGN}
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE cc_result
+        OUTPUT_VARIABLE cc_output
+        ERROR_VARIABLE cc_output
+    )
+    if(NOT cc_result EQUAL 0)
+        message(FATAL_ERROR "cc ${ARGN} failed:\n${cc_output}")
+    endif()
+endfunction()
+
+function(check_exit what exit_code)
+    if(NOT exit_code STREQUAL EXPECTED_EXIT)
+        message(FATAL_ERROR "${what} exited with ${exit_code}, expected ${EXPECTED_EXIT}")
+    endif()
+endfunction()
+
+if(DEFINED OBJECT_WRITER)
+    execute_process(
+        COMMAND ${OBJECT_WRITER} ${WORK_DIR}/output/extern.o
+        RESULT_VARIABLE writer_result
+    )
+    if(NOT writer_result EQUAL 0)
+        message(FATAL_ERROR "${OBJECT_WRITER} failed")
+    endif()
+
+    link_and_run(${WORK_DIR}/output/extern.o ${WORK_DIR}/output/extern exit_code)
+    check_exit("the object with external calls" ${exit_code})
+    return()
+endif()
+
+configure_file(${SOURCE} ${WORK_DIR}/input/test.c COPYONLY)
+
+# (cc runs ld itself afterwards, with crt paths that need not exist here, so its output is not
+# used)
+run_cc(--object)
+file(RENAME ${WORK_DIR}/output/test.o ${WORK_DIR}/output/object.o)
+link_and_run(${WORK_DIR}/output/object.o ${WORK_DIR}/output/object exit_code)
+check_exit("the object written by cc --object" ${exit_code})
+
+run_cc()
+run(${WORK_DIR}/output/test exit_code)
+check_exit("the executable linked by cc" ${exit_code})
+
+find_program(NASM nasm)
+if(NASM)
+    run_cc(--asm)
+    link_and_run(${WORK_DIR}/output/test.o ${WORK_DIR}/output/assembly exit_code)
+    check_exit("the --asm build" ${exit_code})
+else()
+    message(STATUS "nasm not found, not comparing with the --asm build")
+endif()
@@ -0,0 +1,31 @@
+# Runs cc on SOURCE and checks that it fails with the parse error EXPECTED
+#
+#   cmake -DCC=<cc> -DSOURCE=<file.c> -DEXPECTED=<message> -DWORK_DIR=<dir> -P parse_error.cmake
+#
+# cc reads input/test.c and writes output/ relative to the working directory, so every test gets
+# its own WORK_DIR
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/input ${WORK_DIR}/output)
+configure_file(${SOURCE} ${WORK_DIR}/input/test.c COPYONLY)
+
+execute_process(
+    COMMAND ${CC}
+    WORKING_DIRECTORY ${WORK_DIR}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+
+# the messages are colored
+string(ASCII 27 escape)
+string(REGEX REPLACE "${escape}\\[[0-9;]*m" "" output "${output}")
+
+if(result EQUAL 0)
+    message(FATAL_ERROR "${SOURCE} parsed, expected: ${EXPECTED}")
+endif()
+
+string(FIND "${output}" "[Parse Error] ${EXPECTED}\n" found)
+if(found EQUAL -1)
+    message(FATAL_ERROR "expected the parse error:\n  ${EXPECTED}\ngot:\n${output}")
+endif()
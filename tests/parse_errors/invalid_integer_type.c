@@ -0,0 +1,4 @@
+int main() {
+    int int x = 1;
+    return x;
+}
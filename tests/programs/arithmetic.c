@@ -0,0 +1,9 @@
+int square(int x) {
+    return x * x;
+}
+
+int main() {
+    int a = 5;
+    int b = a - 2;
+    return square(a) + square(b) + (a + b) / 2 * 2;
+}
@@ -0,0 +1,15 @@
+long f(long a) {
+    return a + 1;
+}
+
+int g(int a, int b) {
+    int c = a * b - a / b;
+    c = c + (a - b) * (a + b) - 3;
+    return a + b + c + a + b + c - f(a) - f(b);
+}
+
+int main() {    
+    short s = 3;
+    long x = s;
+    return f(x) + f(x) + g(1, 2);
+}